@@ -0,0 +1,278 @@
+"""Benchmarks of the optimizer, the encoders, and the simulators.
+
+Every circuit of 'CircuitBuilder', and the generated adders, comparators, and
+multipliers of a few sizes (see 'nand.circuit_generators'), are measured at every
+optimization level:
+- the time to optimize the circuit,
+- the time to build the simulator,
+- the latency of the simulation of a single vector,
+- the throughput, in vectors and in NAND evaluations per second. For the batch
+  simulators, the vectors are simulated in batches of '--lanes' vectors.
+
+The encoders are measured on the library of 'CircuitBuilder', and on the library of
+each generated circuit, in MB per second of encoded data. The default encoder only has
+a byte per count, so it's skipped for the largest circuits.
+
+Each measure is the best of '--repeats' runs. The results are written as JSON, to
+track the regressions between releases.
+
+Usage (from the repository root):
+    PYTHONPATH=src python benchmarks/run_benchmarks.py --output results.json
+"""
+
+import argparse
+import json
+import platform
+import random
+import subprocess
+import sys
+import time
+from copy import deepcopy
+from datetime import datetime, timezone
+from typing import Callable, Dict, List, Optional, Sequence, Tuple, Type
+
+from nand.bit_packed_decoder import BitPackedDecoder
+from nand.bit_packed_encoder import BitPackedEncoder
+from nand.circuit import Circuit
+from nand.circuit_generators import (
+    array_multiplier,
+    carry_lookahead_adder,
+    comparator,
+    ripple_carry_adder,
+)
+from nand.circuit_decoder import CircuitDecoder
+from nand.circuit_encoder import CircuitEncoder
+from nand.circuit_optimizer import optimize
+from nand.circuits_library import CircuitBuilder, CircuitLibrary, library_from_circuit
+from nand.default_decoder import DefaultDecoder
+from nand.default_encoder import DefaultEncoder
+from nand.entropy_decoder import EntropyDecoder
+from nand.entropy_encoder import EntropyEncoder
+from nand.flat_netlist import flatten
+from nand.optimization_level import OptimizationLevel
+from nand.simulator_bit_parallel import BatchSimulator
+from nand.simulator_builder import build_simulator
+from nand.simulator_gpu import is_gpu_available
+from nand.simulator_native import is_native_available
+
+ENCODERS: List[Tuple[Type[CircuitEncoder], Type[CircuitDecoder]]] = [
+    (DefaultEncoder, DefaultDecoder),
+    (BitPackedEncoder, BitPackedDecoder),
+    (EntropyEncoder, EntropyDecoder),
+]
+
+DEFAULT_SIZES = [8, 16, 32]
+
+
+def measure(function: Callable[[], object], repeats: int) -> float:
+    """The best time of a few calls of a function, in seconds."""
+    best = float("inf")
+    for _ in range(max(1, repeats)):
+        start = time.perf_counter()
+        function()
+        best = min(best, time.perf_counter() - start)
+    return best
+
+
+def generated_circuits(
+    library: CircuitLibrary, sizes: Sequence[int]
+) -> List[Circuit]:
+    """The larger circuits of 'nand.circuit_generators', for each size in bits."""
+    circuits = []
+    for bits in sizes:
+        circuits.append(ripple_carry_adder(bits, library))
+        circuits.append(carry_lookahead_adder(bits, library))
+        circuits.append(comparator(bits, library))
+        circuits.append(array_multiplier(bits, library))
+    return circuits
+
+
+def benchmark_circuit(
+    circuit: Circuit,
+    levels: Sequence[OptimizationLevel],
+    repeats: int,
+    vectors: int,
+    lanes: int,
+) -> List[Dict]:
+    """Benchmark a circuit at each optimization level."""
+    nands_count = flatten(circuit).nands_count
+    n_inputs = len(circuit.inputs)
+    rng = random.Random(0)
+    inputs = [[rng.random() < 0.5 for _ in range(n_inputs)] for _ in range(vectors)]
+    words = [rng.getrandbits(lanes) for _ in range(n_inputs)]
+
+    optimize_time = measure(lambda: optimize(circuit), repeats)
+
+    results = []
+    for level in levels:
+        # Each build is on its own copy, as some simulators convert the wires.
+        copies = [deepcopy(circuit) for _ in range(max(1, repeats))]
+        build_time = measure(lambda: build_simulator(copies.pop(), level), repeats)
+        simulator = build_simulator(deepcopy(circuit), level)
+
+        def simulate_vectors():
+            for vector in inputs:
+                simulator.simulate(vector)
+
+        latency = measure(simulate_vectors, repeats) / vectors
+        vectors_per_second = 1 / latency
+        batch_lanes: Optional[int] = None
+        if isinstance(simulator, BatchSimulator):
+            batch_time = measure(
+                lambda: simulator.simulate_words(words, lanes), repeats
+            )
+            vectors_per_second = max(vectors_per_second, lanes / batch_time)
+            batch_lanes = lanes
+
+        results.append(
+            {
+                "circuit": str(circuit.identifier),
+                "level": level.name,
+                "nands": nands_count,
+                "inputs": n_inputs,
+                "outputs": len(circuit.outputs),
+                "optimize_s": optimize_time,
+                "build_s": build_time,
+                "latency_s": latency,
+                "batch_lanes": batch_lanes,
+                "vectors_per_s": vectors_per_second,
+                "nands_per_s": vectors_per_second * nands_count,
+            }
+        )
+    return results
+
+
+def benchmark_encoders(
+    libraries: Sequence[Tuple[str, CircuitLibrary]], repeats: int
+) -> List[Dict]:
+    """Benchmark each encoder and its decoder on each library."""
+    results = []
+    for name, library in libraries:
+        print(f"Benchmarking the encoders on {name}...", file=sys.stderr)
+        results += _benchmark_encoders(name, library, repeats)
+    return results
+
+
+def _benchmark_encoders(name: str, library: CircuitLibrary, repeats: int) -> List[Dict]:
+    results = []
+    for encoder, decoder in ENCODERS:
+        try:
+            encoding = encoder().encode(library)
+        except OverflowError:
+            print(f"{encoder.__name__} can't encode {name}.", file=sys.stderr)
+            continue
+        megabytes = len(encoding) / 8 / 1e6
+        encode_time = measure(lambda: encoder().encode(library), repeats)
+        decode_time = measure(lambda: decoder().decode(encoding), repeats)
+        results.append(
+            {
+                "library": name,
+                "encoder": encoder.__name__,
+                "circuits": len(library.library),
+                "bits": len(encoding),
+                "encode_s": encode_time,
+                "decode_s": decode_time,
+                "encode_mb_per_s": megabytes / encode_time,
+                "decode_mb_per_s": megabytes / decode_time,
+            }
+        )
+    return results
+
+
+def git_revision() -> Optional[str]:
+    try:
+        result = subprocess.run(
+            ["git", "rev-parse", "HEAD"], capture_output=True, text=True, check=True
+        )
+    except (OSError, subprocess.CalledProcessError):
+        return None
+    return result.stdout.strip()
+
+
+def parse_arguments(arguments: Optional[Sequence[str]] = None) -> argparse.Namespace:
+    available = [
+        level.name
+        for level in OptimizationLevel
+        if (level is not OptimizationLevel.NATIVE or is_native_available())
+        and (level is not OptimizationLevel.GPU or is_gpu_available())
+    ]
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--output", "-o", help="The JSON file, stdout by default.")
+    parser.add_argument(
+        "--levels",
+        nargs="+",
+        choices=available,
+        default=available,
+        help="The optimization levels, all the available ones by default.",
+    )
+    parser.add_argument(
+        "--sizes",
+        nargs="*",
+        type=int,
+        default=DEFAULT_SIZES,
+        help="The sizes in bits of the generated adders, comparators and multipliers.",
+    )
+    parser.add_argument("--repeats", type=int, default=3)
+    parser.add_argument(
+        "--vectors",
+        type=int,
+        default=100,
+        help="The number of vectors to measure the single vector latency.",
+    )
+    parser.add_argument(
+        "--lanes",
+        type=int,
+        default=1024,
+        help="The number of vectors of a batch, for the batch simulators.",
+    )
+    return parser.parse_args(arguments)
+
+
+def main(arguments: Optional[Sequence[str]] = None):
+    options = parse_arguments(arguments)
+    levels = [OptimizationLevel[name] for name in options.levels]
+
+    builder = CircuitBuilder()
+    builder.build_circuits()
+    library = builder.library
+    generated = generated_circuits(library, options.sizes)
+    circuits = list(library.get_all_circuits().values()) + generated
+
+    simulations = []
+    for circuit in circuits:
+        print(f"Benchmarking {circuit.identifier}...", file=sys.stderr)
+        simulations += benchmark_circuit(
+            circuit, levels, options.repeats, options.vectors, options.lanes
+        )
+
+    report = {
+        "metadata": {
+            "date": datetime.now(timezone.utc).isoformat(),
+            "revision": git_revision(),
+            "python": platform.python_version(),
+            "platform": platform.platform(),
+            "native": is_native_available(),
+            "gpu": is_gpu_available(),
+            "repeats": options.repeats,
+        },
+        "simulations": simulations,
+        "encodings": benchmark_encoders(
+            [("CircuitBuilder", library)]
+            + [
+                (str(circuit.identifier), library_from_circuit(circuit))
+                for circuit in generated
+            ],
+            options.repeats,
+        ),
+    }
+
+    output = json.dumps(report, indent=2)
+    if options.output is None:
+        print(output)
+    else:
+        with open(options.output, "w") as file:
+            file.write(output + "\n")
+
+
+if __name__ == "__main__":
+    main()
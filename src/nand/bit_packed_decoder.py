@@ -1,10 +1,16 @@
+from typing import Optional
+
 from bitarray import bitarray
 
 from nand.bit_packed_encoder import bitlength_with_offset
-from nand.bits_utils import read_bits, read_bits_with_offset
-from nand.circuit import Circuit
+from nand.bits_utils import BitReader
+from nand.circuit import Circuit, CircuitId
 from nand.circuit_decoder import CircuitDecoder
-from nand.decoded_circuit import ConnectionParameters, DecodedCircuit, InputParameters
+from nand.decoded_circuit import (
+    ConnectionParameters,
+    DecodedCircuit,
+    InputParameters,
+)
 from nand.circuits_library import CircuitLibrary
 
 
@@ -31,27 +37,62 @@ class BitPackedDecoder(CircuitDecoder):
     less commented.
     """
 
-    def __init__(self):
-        self.library = CircuitLibrary()
-        self.library.add_circuit(self._build_nand())
+    def __init__(self, library: Optional[CircuitLibrary] = None):
+        """
+        Args:
+            library: The library to decode the circuits into, and to get their
+            components from. A new library with the NAND gate by default.
+        """
+        if library is None:
+            library = CircuitLibrary()
+            library.add_circuit(self._build_nand())
+        self.library = library
         self.idx = 0
 
     def decode(self, data: bitarray) -> CircuitLibrary:
         """Decode the data into circuits."""
-        self.data = list(data.tolist())
+        self.data = BitReader(data)
 
         self._decode_global_header()
-        while len(self.data) > 0:
-            # The index is used as the identifier of the circuit
-            self.idx += 1
-            # The current circuit being decoded
-            self.circuit = DecodedCircuit(self.idx)
-            self._decode_circuit()
-            self.circuit.apply_inputs()
-            self.circuit.apply_connections()
-            self.library.add_circuit(self.circuit)
+        while not self.data.at_end():
+            self._decode_next_circuit()
         return self.library
 
+    def decode_circuit_at(self, data: bitarray, position: int, idx: int) -> Circuit:
+        """Decode a single circuit of the data, without the ones before it.
+
+        Only the global header is decoded before jumping to the circuit. Its
+        components are taken from the library, so they must be in it, or decodable
+        on demand by it (see 'LazyCircuitLibrary').
+
+        Args:
+            data: The encoded data.
+            position: The bit offset of the circuit in the data.
+            idx: The index of the circuit in the data, which is its identifier.
+        """
+        self.data = BitReader(data)
+        self._decode_global_header()
+        self.data.position = position
+        self.idx = idx - 1
+        return self._decode_next_circuit()
+
+    def _decode_next_circuit(self) -> Circuit:
+        # The index is used as the identifier of the circuit
+        self.idx += 1
+        # The current circuit being decoded
+        self.circuit = DecodedCircuit(self.idx)
+        self._decode_circuit()
+        return self._apply_circuit(self.circuit)
+
+    def _apply_circuit(self, circuit: DecodedCircuit) -> Circuit:
+        """Apply the stashed connections of a decoded circuit, and add it to the
+        library."""
+        with circuit.deferred_wiring():
+            circuit.apply_inputs()
+            circuit.apply_connections()
+        self.library.add_circuit(circuit)
+        return circuit
+
     def _decode_global_header(self):
         """Decode the global header of the bit stream.
 
@@ -63,13 +104,13 @@ class BitPackedDecoder(CircuitDecoder):
         - max_inputs_bitlength: The number of bits for the count of inputs in a circuit.
         - max_outputs_bitlength: The number of bits for the count of outputs in a circuit.
         """
-        header_bitlength = read_bits_with_offset(self.data, 2)
-        self.circuits_bitlength = read_bits_with_offset(self.data, header_bitlength)
-        self.max_components_bitlength = read_bits_with_offset(
-            self.data, header_bitlength
+        header_bitlength = self.data.read_with_offset(2)
+        self.circuits_bitlength = self.data.read_with_offset(header_bitlength)
+        self.max_components_bitlength = self.data.read_with_offset(
+            header_bitlength
         )
-        self.max_inputs_bitlength = read_bits_with_offset(self.data, header_bitlength)
-        self.max_outputs_bitlength = read_bits_with_offset(self.data, header_bitlength)
+        self.max_inputs_bitlength = self.data.read_with_offset(header_bitlength)
+        self.max_outputs_bitlength = self.data.read_with_offset(header_bitlength)
 
     def _decode_circuit(self):
         """Decode a single circuit from the data stream."""
@@ -86,39 +127,42 @@ class BitPackedDecoder(CircuitDecoder):
         for component indices, input indices, and output indices within this circuit's
         scope.
         """
-        self.circuit.components_count = read_bits_with_offset(
-            self.data, self.max_components_bitlength
+        self.circuit.components_count = self.data.read_with_offset(
+            self.max_components_bitlength
         )
         self.components_bitlength = bitlength_with_offset(self.circuit.components_count)
 
-        self.circuit.inputs_count = read_bits_with_offset(
-            self.data, self.max_inputs_bitlength
+        self.circuit.inputs_count = self.data.read_with_offset(
+            self.max_inputs_bitlength
         )
         self.inputs_bitlength = bitlength_with_offset(self.circuit.inputs_count)
 
-        self.circuit.outputs_count = read_bits_with_offset(
-            self.data, self.max_outputs_bitlength
+        self.circuit.outputs_count = self.data.read_with_offset(
+            self.max_outputs_bitlength
         )
         self.outputs_bitlength = bitlength_with_offset(self.circuit.outputs_count)
 
     def _decode_component(self, component_idx: int):
         """Decode the component_idx-th component of the circuit."""
-        circuit_id = read_bits(self.data, self.circuits_bitlength)
+        circuit_id = self.data.read(self.circuits_bitlength)
+        component = self._get_component(circuit_id)
+        self.circuit.add_component(component_idx, component)
+        self._decode_component_inputs(component_idx, len(component.inputs))
+
+    def _get_component(self, circuit_id: CircuitId) -> Circuit:
         try:
-            component = self.library.get_circuit(circuit_id)
+            return self.library.get_circuit(circuit_id)
         except ValueError as e:
             raise ValueError(
                 f"Trying to use the undefined component {circuit_id}."
             ) from e
-        self.circuit.add_component(component_idx, component)
-        self._decode_component_inputs(component_idx, component)
 
-    def _decode_component_inputs(self, component_idx: int, component: Circuit):
-        """Decode the inputs of 'component', the 'component_idx'-th component
-        of the circuit.
+    def _decode_component_inputs(self, component_idx: int, inputs_count: int):
+        """Decode the 'inputs_count' inputs of the 'component_idx'-th component of
+        the circuit.
         """
-        for input_idx in range(0, len(component.inputs)):
-            provenance = self.data.pop(0)
+        for input_idx in range(0, inputs_count):
+            provenance = self.data.read_bit()
             if provenance == 0:
                 self._decode_circuit_provenance(input_idx, component_idx)
             elif provenance == 1:
@@ -133,7 +177,7 @@ class BitPackedDecoder(CircuitDecoder):
         """Decode the 'input_idx'-th input of the 'component_idx'-th component of the
         circuit, originating from the circuit's inputs.
         """
-        circuit_input_idx = read_bits(self.data, self.inputs_bitlength)
+        circuit_input_idx = self.data.read(self.inputs_bitlength)
         if circuit_input_idx >= self.circuit.inputs_count:
             raise ValueError(
                 f"Circuit {self.circuit.identifier}: the {component_idx}-th component "
@@ -187,7 +231,7 @@ class BitPackedDecoder(CircuitDecoder):
         """Decode the wiring between components: the source component index
         and its output index.
         """
-        source_idx = read_bits(self.data, self.components_bitlength)
+        source_idx = self.data.read(self.components_bitlength)
 
         if source_idx >= self.circuit.components_count:
             raise ValueError(
@@ -195,6 +239,6 @@ class BitPackedDecoder(CircuitDecoder):
                 f"(there is {self.circuit.components_count} components)."
             )
 
-        source_output_idx = read_bits(self.data, self.outputs_bitlength)
+        source_output_idx = self.data.read(self.outputs_bitlength)
 
         return (source_idx, source_output_idx)
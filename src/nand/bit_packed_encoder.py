@@ -1,11 +1,9 @@
-from copy import deepcopy
-from enum import Enum, auto
-from typing import List, Tuple
+from typing import Dict, List, Tuple
 
 from bitarray import bitarray
 
-from nand.bits_utils import bitlength_with_offset, int2bitlist, int2bitlist_with_offset
-from nand.circuit import Circuit, CircuitDict, Wire
+from nand.bits_utils import BitWriter, bitlength_with_offset
+from nand.circuit import Circuit, CircuitDict, CircuitId, Wire
 from nand.circuit_encoder import CircuitEncoder
 from nand.circuits_library import CircuitLibrary
 
@@ -15,14 +13,10 @@ class EncodedCircuitMetadata:
         self.components_bitlength = 0
         self.inputs_bitlength = 0
         self.outputs_bitlength = 0
-
-
-class Placeholder(Enum):
-    """Placeholder category for the bitlength when it is not known yet."""
-
-    COMPONENTS = auto()
-    INPUTS = auto()
-    OUTPUTS = auto()
+        # The index of each wire of the circuit inputs, and the source of each wire
+        # driven by a component: its index, and the index of the output.
+        self.inputs_indices: Dict[int, int] = {}
+        self.drivers: Dict[int, Tuple[int, int]] = {}
 
 
 class BitPackedEncoder(CircuitEncoder):
@@ -63,9 +57,10 @@ class BitPackedEncoder(CircuitEncoder):
 
     More details are in the methods themselves.
 
-    The encoding is destructive: the components, inputs, and outputs are replaced by
-    their indices these will become the new "names" during decoding. The order, which
-    define functionality, is preserved.
+    The library isn't copied, nor modified. The maximum counts of the global header
+    are computed first, in a quick pass on the circuits, so that each field can then
+    be written directly in its final place: the encoding is a single pass, and the
+    memory used is about the size of the output.
 
     The main task is to define the wiring that connects the inputs, outputs,
     and components together. The core idea is not to define the wires themselves, but to
@@ -76,10 +71,14 @@ class BitPackedEncoder(CircuitEncoder):
 
     def __init__(self):
         super().__init__()
+        self._reset()
 
+    def _reset(self):
+        """Start a new stream: an encoder can encode several libraries in turn."""
         self.library: CircuitDict = {}
-        # [data ; bitlength]
-        self.int_encoding: List[Tuple[int, int | Placeholder]] = []
+        # The index of each circuit in the library, which is its encoded identifier.
+        self.circuit_indices: Dict[CircuitId, int] = {}
+        self.writer = BitWriter()
 
         # Variables to keep count of the maximum number of components, inputs, and
         # outputs in the library. They will be in the global header.
@@ -87,19 +86,28 @@ class BitPackedEncoder(CircuitEncoder):
         self.max_inputs = 0
         self.max_outputs = 0
 
+        # The bit offset of each circuit in the stream, the i-th one being the circuit
+        # of index i + 1 (the NAND gate isn't encoded).
+        self.circuit_offsets: List[int] = []
+
     def encode(self, library: CircuitLibrary) -> bitarray:
         """
         Orchestrates the encoding process.
         """
-        self.library = deepcopy(library.library)
+        self._reset()
+        self.library = library.library
+        self.circuit_indices = {
+            identifier: idx for idx, identifier in enumerate(self.library)
+        }
         # See comment for 'max_*_bitlength' variables for explanation.
         self.circuits_bitlength: int = bitlength_with_offset(len(self.library))
 
-        # Core encoding
-        for circuit in self.library.values():
-            if circuit.identifier == 0:
-                continue
-            self._encode_circuit(circuit)
+        # The global maximums, which define the bit length of the circuit headers.
+        circuits = [c for c in self.library.values() if c.identifier != 0]
+        for circuit in circuits:
+            self.max_components = max(self.max_components, len(circuit.components))
+            self.max_inputs = max(self.max_inputs, len(circuit.inputs))
+            self.max_outputs = max(self.max_outputs, len(circuit.outputs))
 
         # Compute the number of bits necessary to encode the number of circuits,
         # maximum number of components, inputs and outputs necessary
@@ -117,9 +125,9 @@ class BitPackedEncoder(CircuitEncoder):
         #       to decode the number of component for each circuit.
         #     - For each local circuit header, we will decode the number of components
         #       by reading 3 bits.
-        max_components_bitlength = bitlength_with_offset(self.max_components)
-        max_inputs_bitlength = bitlength_with_offset(self.max_inputs)
-        max_outputs_bitlength = bitlength_with_offset(self.max_outputs)
+        self.max_components_bitlength = bitlength_with_offset(self.max_components)
+        self.max_inputs_bitlength = bitlength_with_offset(self.max_inputs)
+        self.max_outputs_bitlength = bitlength_with_offset(self.max_outputs)
 
         # Here is the third level of bit counting. We do the same as the previous step,
         # but with the maximum number of all maximum bit lengths.
@@ -138,14 +146,12 @@ class BitPackedEncoder(CircuitEncoder):
         #   - For each of these elements, we will decode them by reading 3 bits.
         max_bitlength = max(
             self.circuits_bitlength,
-            max_components_bitlength,
-            max_inputs_bitlength,
-            max_outputs_bitlength,
+            self.max_components_bitlength,
+            self.max_inputs_bitlength,
+            self.max_outputs_bitlength,
         )
         core_bitlength = bitlength_with_offset(max_bitlength)
 
-        bit_encoding = bitarray()
-
         # Global Header
         # Now, we will encode these previous numbers. But there's a new twist: these
         # encoding are also offset by one, as a bit size of '0' makes no sense.
@@ -165,43 +171,19 @@ class BitPackedEncoder(CircuitEncoder):
         #     will be 2 + 1 = 3, with the offset.
         #   - For the circuit with the maximum of 8 components, we will read the
         #     3 bits '111' = 7 + 1 = 8, with the offset. It's all coming together!
-        bit_encoding.extend(int2bitlist_with_offset(core_bitlength, 2))
-        bit_encoding.extend(
-            int2bitlist_with_offset(self.circuits_bitlength, core_bitlength)
-        )
-        bit_encoding.extend(
-            int2bitlist_with_offset(max_components_bitlength, core_bitlength)
-        )
-        bit_encoding.extend(
-            int2bitlist_with_offset(max_inputs_bitlength, core_bitlength)
-        )
-        bit_encoding.extend(
-            int2bitlist_with_offset(max_outputs_bitlength, core_bitlength)
-        )
+        writer = self.writer
+        writer.write_with_offset(core_bitlength, 2)
+        writer.write_with_offset(self.circuits_bitlength, core_bitlength)
+        writer.write_with_offset(self.max_components_bitlength, core_bitlength)
+        writer.write_with_offset(self.max_inputs_bitlength, core_bitlength)
+        writer.write_with_offset(self.max_outputs_bitlength, core_bitlength)
 
-        # Finally encode the data. The raw encoding contains the integers values to
-        # encode into bits, and the bit length if it was known, or a placeholder
-        # that is now defined.
-        for data, bitlength in self.int_encoding:
-            match bitlength:
-                case Placeholder.COMPONENTS:
-                    bit_encoding.extend(
-                        int2bitlist_with_offset(data, max_components_bitlength)
-                    )
-                case Placeholder.INPUTS:
-                    bit_encoding.extend(
-                        int2bitlist_with_offset(data, max_inputs_bitlength)
-                    )
-                case Placeholder.OUTPUTS:
-                    bit_encoding.extend(
-                        int2bitlist_with_offset(data, max_outputs_bitlength)
-                    )
-                case int():
-                    bit_encoding.extend(int2bitlist(data, bitlength))
-                case _:
-                    raise ValueError("Unknown bitlength type.")
-
-        return bit_encoding
+        # Core encoding
+        for circuit in circuits:
+            self.circuit_offsets.append(writer.position)
+            self._encode_circuit(circuit)
+
+        return writer.data
 
     def _encode_circuit(self, circuit: Circuit):
         """
@@ -222,22 +204,28 @@ class BitPackedEncoder(CircuitEncoder):
         # the different elements.
         metadata = EncodedCircuitMetadata()
 
-        # We "stash" the encoding: the number of components (with offset), will
-        # be encoded in a number of bits deduced by the global maximum.
-        self.int_encoding.append((len(circuit.components), Placeholder.COMPONENTS))
-        # Update the global maximum.
-        self.max_components = max(self.max_components, len(circuit.components))
+        # The number of components (with offset), is encoded in a number of bits
+        # deduced by the global maximum.
+        self.writer.write_with_offset(
+            len(circuit.components), self.max_components_bitlength
+        )
         # Compute how many bits are necessary to encode the index of components.
         metadata.components_bitlength = bitlength_with_offset(len(circuit.components))
 
-        self.int_encoding.append((len(circuit.inputs), Placeholder.INPUTS))
-        self.max_inputs = max(self.max_inputs, len(circuit.inputs))
+        self.writer.write_with_offset(len(circuit.inputs), self.max_inputs_bitlength)
         metadata.inputs_bitlength = bitlength_with_offset(len(circuit.inputs))
 
-        self.int_encoding.append((len(circuit.outputs), Placeholder.OUTPUTS))
-        self.max_outputs = max(self.max_outputs, len(circuit.outputs))
+        self.writer.write_with_offset(len(circuit.outputs), self.max_outputs_bitlength)
         metadata.outputs_bitlength = bitlength_with_offset(len(circuit.outputs))
 
+        # The lookup tables of the wiring, the first port of a wire taking
+        # precedence.
+        for idx, wire in enumerate(circuit.inputs.values()):
+            metadata.inputs_indices.setdefault(wire.id, idx)
+        for idx, component in enumerate(circuit.components.values()):
+            for output_idx, wire in enumerate(component.outputs.values()):
+                metadata.drivers.setdefault(wire.id, (idx, output_idx))
+
         return metadata
 
     def _encode_components(self, circuit: Circuit, metadata: EncodedCircuitMetadata):
@@ -257,10 +245,10 @@ class BitPackedEncoder(CircuitEncoder):
         library is unique, and that's what we encode.
         During decoding, this index will be the new id.
         """
-        circuit_ids = list(self.library.keys())
-
-        self.int_encoding.append(
-            (circuit_ids.index(component.identifier), self.circuits_bitlength)
+        if component.identifier not in self.circuit_indices:
+            raise ValueError(f"Circuit {component.identifier} is not in the library")
+        self.writer.write(
+            self.circuit_indices[component.identifier], self.circuits_bitlength
         )
 
         self._encode_inputs(component, circuit, metadata)
@@ -289,17 +277,15 @@ class BitPackedEncoder(CircuitEncoder):
         if the number of outputs is greater than the number of inputs, like for the
         nand2tetris CPU (but not for the ALU).
         """
-        circuit_input = [wire.id for wire in circuit.inputs.values()]
-
         for input in component.inputs.values():
-            if input.id in circuit_input:
-                self.int_encoding.append((0, 1))
-                self.int_encoding.append(
-                    (circuit_input.index(input.id), metadata.inputs_bitlength)
+            if input.id in metadata.inputs_indices:
+                self.writer.write_bit(0)
+                self.writer.write(
+                    metadata.inputs_indices[input.id], metadata.inputs_bitlength
                 )
             else:
-                self.int_encoding.append((1, 1))
-                self._encode_component_wiring(input, circuit.components, metadata)
+                self.writer.write_bit(1)
+                self._encode_component_wiring(input, metadata)
 
     def _encode_outputs(self, circuit: Circuit, metadata: EncodedCircuitMetadata):
         """
@@ -307,23 +293,17 @@ class BitPackedEncoder(CircuitEncoder):
         output = wiring (see _encode_component_wiring())
         """
         for output in circuit.outputs.values():
-            self._encode_component_wiring(output, circuit.components, metadata)
+            self._encode_component_wiring(output, metadata)
 
-    def _encode_component_wiring(
-        self, wire: Wire, components: CircuitDict, metadata: EncodedCircuitMetadata
-    ):
+    def _encode_component_wiring(self, wire: Wire, metadata: EncodedCircuitMetadata):
         """
         wiring = [component_idx, output_idx]
         component_idx is the index of source component within the current circuit.
         output_idx is the index of the output in the component pin on that source
         component.
         """
-        for idx, sub_component in enumerate(components.values()):
-            outputs = [wire.id for wire in sub_component.outputs.values()]
-            if wire.id in outputs:
-                self.int_encoding.append((idx, metadata.components_bitlength))
-                self.int_encoding.append(
-                    (outputs.index(wire.id), metadata.outputs_bitlength)
-                )
-                return
-        raise ValueError(f"Wire {wire.id} not found in any sub_component outputs")
+        if wire.id not in metadata.drivers:
+            raise ValueError(f"Wire {wire.id} not found in any sub_component outputs")
+        component_idx, output_idx = metadata.drivers[wire.id]
+        self.writer.write(component_idx, metadata.components_bitlength)
+        self.writer.write(output_idx, metadata.outputs_bitlength)
@@ -0,0 +1,189 @@
+from typing import List, Optional, Tuple
+
+from bitarray import bitarray
+
+from nand.bits_utils import BitReader, bitlength_with_offset
+from nand.circuit import CircuitId
+from nand.circuit_definition import (
+    ComponentBindings,
+    CircuitDefinition,
+    CircuitDefinitions,
+    Source,
+    definition_from_bindings,
+)
+from nand.flat_netlist import FlatNetlist, flatten_definition
+
+# The NAND gate, with the port identifiers of the decoded circuits.
+DECODED_NAND_DEFINITION = CircuitDefinition(
+    identifier=0,
+    name="0",
+    inputs=(0, 1),
+    outputs=(0,),
+    output_slots=(2,),
+    components=(),
+    slots_count=3,
+)
+
+# A circuit parsed without its components' definitions: its number of inputs, the
+# identifier and the input sources of each component, and the output sources.
+type ParsedCircuit = Tuple[int, List[Tuple[CircuitId, List[Source]]], List[Source]]
+
+
+class BitPackedLoader:
+    """Load the output of 'BitPackedEncoder' directly into circuit definitions.
+
+    Contrary to 'BitPackedDecoder', there isn't any 'Circuit' or 'Wire' object: each
+    circuit is read in a single pass over its bits, into a definition referencing the
+    definitions of its components (see 'CircuitDefinition'). Then, a circuit can be
+    flattened into the netlist of the fast simulators right away.
+
+    Like with the decoder, the circuits are identified by their index, the NAND gate
+    being 0, and so are their inputs and outputs.
+
+    'BitPackedEncoder' comments are the source of truth for the format, and the
+    decoding steps are the same as 'BitPackedDecoder'.
+    """
+
+    def __init__(self):
+        self.definitions: CircuitDefinitions = {0: DECODED_NAND_DEFINITION}
+        # The number of inputs of each circuit, to parse the inputs of its instances.
+        self.inputs_counts: List[int] = [2]
+
+    def load(self, data: bitarray) -> CircuitDefinitions:
+        """Load all the circuits of the stream.
+
+        Returns:
+            The definitions, by identifier, in the order of the stream.
+        """
+        self.data = BitReader(data)
+        self._load_global_header()
+        while not self.data.at_end():
+            identifier = len(self.definitions)
+            parsed = self._parse_circuit(identifier)
+            self.inputs_counts.append(parsed[0])
+            self.definitions[identifier] = self._build_definition(identifier, parsed)
+        return self.definitions
+
+    def _load_global_header(self):
+        header_bitlength = self.data.read_with_offset(2)
+        self.circuits_bitlength = self.data.read_with_offset(header_bitlength)
+        self.max_components_bitlength = self.data.read_with_offset(header_bitlength)
+        self.max_inputs_bitlength = self.data.read_with_offset(header_bitlength)
+        self.max_outputs_bitlength = self.data.read_with_offset(header_bitlength)
+
+    def _parse_circuit(self, identifier: CircuitId) -> ParsedCircuit:
+        """Parse the circuit at the current position, with the identifiers of its
+        components, without their definitions."""
+        components_count = self.data.read_with_offset(self.max_components_bitlength)
+        inputs_count = self.data.read_with_offset(self.max_inputs_bitlength)
+        outputs_count = self.data.read_with_offset(self.max_outputs_bitlength)
+        components_bitlength = bitlength_with_offset(components_count)
+        inputs_bitlength = bitlength_with_offset(inputs_count)
+        outputs_bitlength = bitlength_with_offset(outputs_count)
+
+        components: List[Tuple[CircuitId, List[Source]]] = []
+        for component_idx in range(components_count):
+            circuit_id = self.data.read(self.circuits_bitlength)
+            # A circuit can only use the circuits before it.
+            if circuit_id >= identifier:
+                raise ValueError(f"Trying to use the undefined component {circuit_id}.")
+
+            bindings: List[Source] = []
+            for input_idx in range(self.inputs_counts[circuit_id]):
+                if self.data.read_bit() == 0:
+                    circuit_input_idx = self.data.read(inputs_bitlength)
+                    if circuit_input_idx >= inputs_count:
+                        raise ValueError(
+                            f"Circuit {identifier}: the {component_idx}-th component "
+                            f"asked for its {input_idx}-th input the "
+                            f"{circuit_input_idx}-th input of the circuit itself, "
+                            f"which does not exists (there is {inputs_count} inputs)."
+                        )
+                    bindings.append((-1, circuit_input_idx))
+                else:
+                    bindings.append(
+                        self._load_wiring(
+                            identifier,
+                            components_count,
+                            components_bitlength,
+                            outputs_bitlength,
+                        )
+                    )
+            components.append((circuit_id, bindings))
+
+        outputs = [
+            self._load_wiring(
+                identifier, components_count, components_bitlength, outputs_bitlength
+            )
+            for _ in range(outputs_count)
+        ]
+        return inputs_count, components, outputs
+
+    def _build_definition(
+        self, identifier: CircuitId, parsed: ParsedCircuit
+    ) -> CircuitDefinition:
+        """Build the definition of a parsed circuit, its components' definitions being
+        already built."""
+        inputs_count, parsed_components, outputs = parsed
+        components: List[ComponentBindings] = [
+            (component_idx, self.definitions[circuit_id], bindings)
+            for component_idx, (circuit_id, bindings) in enumerate(parsed_components)
+        ]
+        self._check_wiring(identifier, components, outputs)
+        return definition_from_bindings(
+            identifier,
+            str(identifier),
+            range(inputs_count),
+            components,
+            dict(enumerate(outputs)),
+        )
+
+    def _load_wiring(
+        self,
+        identifier: CircuitId,
+        components_count: int,
+        components_bitlength: int,
+        outputs_bitlength: int,
+    ) -> Source:
+        """Load the source component index and its output index."""
+        source_idx = self.data.read(components_bitlength)
+        if source_idx >= components_count:
+            raise ValueError(
+                f"Circuit {identifier}: the {source_idx}-th component does not exist "
+                f"(there is {components_count} components)."
+            )
+        return source_idx, self.data.read(outputs_bitlength)
+
+    @staticmethod
+    def _check_wiring(
+        identifier: CircuitId,
+        components: List[ComponentBindings],
+        outputs: List[Source],
+    ):
+        """Check the output indices of the sources, once all the components are
+        known."""
+        sources = [source for _, _, bindings in components for source in bindings]
+        for source_idx, output_idx in sources + outputs:
+            if source_idx >= 0 and output_idx >= len(components[source_idx][1].outputs):
+                raise ValueError(
+                    f"Circuit {identifier}: the {source_idx}-th component does not "
+                    f"have an {output_idx}-th output."
+                )
+
+
+def load_netlist(data: bitarray, identifier: Optional[CircuitId] = None) -> FlatNetlist:
+    """Load a circuit of a bit-packed stream directly into a flat netlist.
+
+    Args:
+        data: The output of 'BitPackedEncoder'.
+        identifier: The index of the circuit to load, the last one by default.
+
+    Returns:
+        The flat netlist of the circuit.
+    """
+    definitions = BitPackedLoader().load(data)
+    if identifier is None:
+        identifier = len(definitions) - 1
+    if identifier not in definitions:
+        raise ValueError(f"Circuit {identifier} does not exist")
+    return flatten_definition(definitions[identifier])
@@ -1,25 +1,108 @@
-from typing import List
+from bitarray import bitarray
+from bitarray.util import ba2int, int2ba
 
 
-def read_bits(data: List[int], n: int) -> int:
-    """Convert the first n bits from a list (integer of value 0 or 1) to an integer."""
-    if len(data) < n:
-        raise ValueError(
-            f"Not enough bits in data (of len {len(data)})"
-            f"to form an integer with {n} requested bits."
-        )
-    bits = [data.pop(0) for _ in range(n)]
-    return sum(bit << i for i, bit in enumerate(reversed(bits)))
+class BitReader:
+    """A cursor reading integer fields from a bit stream, most significant bit first.
 
+    The stream isn't copied: the reader keeps a reference to it, and only the bits of
+    each field are extracted, with 'ba2int()'. So, reading the whole stream is linear
+    in its length.
+    """
 
-def read_bits_with_offset(data: List[int], n: int) -> int:
-    """Convert the first n bits from a list (integer of value 0 or 1) to an integer,
-    with an offset of +1.
-
-    This offset make a '0' become 1, '1' become 2, '10' become 3, etc.
-    See 'BitPackedEncoder' for rational.
+    def __init__(self, data: bitarray | bytes | memoryview, start: int = 0):
+        """
+        Args:
+            data: The bit stream. Bytes are wrapped into a bitarray sharing their
+            buffer.
+            start: The position of the first bit to read.
+        """
+        if isinstance(data, bitarray):
+            self._data = data
+        else:
+            self._data = bitarray(buffer=data)
+        self.position = start
+
+    @property
+    def remaining(self) -> int:
+        """The number of bits left to read."""
+        return len(self._data) - self.position
+
+    def at_end(self) -> bool:
+        return self.position >= len(self._data)
+
+    def read(self, n: int) -> int:
+        """Read the next n bits as an unsigned integer."""
+        if n == 0:
+            return 0
+        end = self.position + n
+        if end > len(self._data):
+            raise ValueError(
+                f"Not enough bits in data (of len {len(self._data)}, at position "
+                f"{self.position}) to form an integer with {n} requested bits."
+            )
+        value = ba2int(self._data[self.position : end])
+        self.position = end
+        return value
+
+    def read_with_offset(self, n: int) -> int:
+        """Read the next n bits as an unsigned integer, with an offset of +1.
+
+        This offset make a '0' become 1, '1' become 2, '10' become 3, etc.
+        See 'BitPackedEncoder' for rational.
+        """
+        return self.read(n) + 1
+
+    def read_bit(self) -> int:
+        """Read the next bit."""
+        if self.position >= len(self._data):
+            raise ValueError(f"Not enough bits in data (of len {len(self._data)}).")
+        bit = self._data[self.position]
+        self.position += 1
+        return bit
+
+    def read_byte(self) -> int:
+        """Read the next 8 bits, e.g. for byte-aligned formats."""
+        return self.read(8)
+
+
+class BitWriter:
+    """A cursor writing integer fields at the end of a bit stream, most significant
+    bit first. The dual of 'BitReader'.
+
+    The fields are written straight into the bitarray, which grows in place.
     """
-    return read_bits(data, n) + 1
+
+    def __init__(self, data: bitarray | None = None):
+        """
+        Args:
+            data: The bit stream to append to, a new one by default.
+        """
+        self.data = bitarray() if data is None else data
+
+    @property
+    def position(self) -> int:
+        """The position of the next bit to write."""
+        return len(self.data)
+
+    def write(self, value: int, n: int):
+        """Write an unsigned integer in n bits."""
+        if value < 0:
+            raise ValueError("Input must be a non-negative integer")
+        if value >> n:
+            raise ValueError(f"Integer {value} requires more than {n} bits to represent")
+        if n:
+            self.data.extend(int2ba(value, length=n))
+
+    def write_with_offset(self, value: int, n: int):
+        """Write an unsigned integer in n bits, with an offset of -1.
+
+        See 'BitReader.read_with_offset()'.
+        """
+        self.write(value - 1, n)
+
+    def write_bit(self, bit: int):
+        self.data.append(bit)
 
 
 def bitlength_with_offset(n: int):
@@ -1,7 +1,10 @@
-from typing import Dict
+from contextlib import contextmanager
+from copy import deepcopy
+from typing import Any, Dict, Iterator, Optional, Self
 
 
 from nand.wire import Wire
+from nand.wire_bindings import WireBindings
 
 # Type aliasing definition. There is a lot of them, but it's easier when developing to
 # have clear hints.
@@ -18,6 +21,20 @@ type PortWireDict = InputWireDict | OutputWireDict
 type PortNameDict = InputNameDict | OutputNameDict
 type CircuitDict = Dict[CircuitId, "Circuit"]
 
+# The attributes copied by 'Circuit.__deepcopy__()' without the generic deep copy.
+_CIRCUIT_ATTRIBUTES = frozenset(
+    (
+        "identifier",
+        "name",
+        "inputs",
+        "inputs_names",
+        "outputs",
+        "outputs_names",
+        "components",
+        "bindings",
+    )
+)
+
 
 class Circuit:
     """A digital circuit recursively composed of other circuits
@@ -57,6 +74,9 @@ class Circuit:
                       for the graphs.
 
         components: Components of the circuit
+
+        bindings: The connections not yet propagated to the components hierarchy, in
+                  the deferred wiring mode. None otherwise.
     """
 
     def __init__(self, identifier: CircuitId):
@@ -67,6 +87,7 @@ class Circuit:
         self.outputs: OutputWireDict = {}
         self.outputs_names: OutputNameDict = {}
         self.components: CircuitDict = {}
+        self.bindings: Optional[WireBindings] = None
 
     def add_component(self, id: CircuitId, component: "Circuit"):
         """Add a component.
@@ -76,6 +97,35 @@ class Circuit:
             component: The component itself.
         """
         self.components[id] = component
+        if self.bindings is not None:
+            self.bindings.add_component(component)
+
+    @contextmanager
+    def deferred_wiring(self) -> Iterator["Circuit"]:
+        """Defer the propagation of the connections to the components hierarchy.
+
+        Each connection walks the hierarchy of its target to replace the references to
+        the old wire: building a circuit with deep components is slow. In this mode,
+        the replacements are recorded in a union-find (see 'WireBindings'), and
+        propagated by a single walk of the hierarchy when leaving the context.
+
+        The circuit must not be simulated, encoded, or copied inside the context, as
+        the wires of its sub-components are not up-to-date yet.
+
+            with circuit.deferred_wiring():
+                circuit.connect_input("A", "ADDER_0", "A")
+                ...
+        """
+        if self.bindings is not None:
+            # Nested contexts: the outermost one resolves the bindings.
+            yield self
+            return
+        self.bindings = WireBindings(self)
+        try:
+            yield self
+        finally:
+            bindings, self.bindings = self.bindings, None
+            bindings.resolve()
 
     def connect_input(
         self, input_id: InputId, target_id: CircuitId, target_input_id: InputId
@@ -105,6 +155,8 @@ class Circuit:
         if input_id not in self.inputs:
             self.inputs[input_id] = Wire()
             self.inputs_names[input_id] = str(input_id)
+            if self.bindings is not None:
+                self.bindings.add_input(self.inputs[input_id])
 
         # The assignment ordering dance is necessary. Setting 'input' as the
         # 'target_input' doesn't work, there is an edge case.
@@ -115,7 +167,7 @@ class Circuit:
         target.inputs[target_input_id] = wire
 
         # Update all matching wire references in the component hierarchy.
-        self._propagate_wire_update(target, old_wire, wire)
+        self._update_wire(target, old_wire, wire)
 
     def connect_output(
         self,
@@ -201,7 +253,23 @@ class Circuit:
         target.inputs[target_input_id] = wire
 
         # Update all matching wire references in the component hierarchy.
-        self._propagate_wire_update(target, old_wire, wire)
+        self._update_wire(target, old_wire, wire)
+
+    def _update_wire(self, component: "Circuit", old_wire: Wire, new_wire: Wire):
+        """Replace a wire in a component hierarchy, now or when leaving the deferred
+        wiring mode.
+
+        A shared wire can only be replaced in the hierarchy of the component, not in
+        the whole circuit: the pending bindings are resolved first, for the
+        replacement to be propagated right away.
+        """
+        if self.bindings is None:
+            self._propagate_wire_update(component, old_wire, new_wire)
+        elif not self.bindings.is_shared(old_wire):
+            self.bindings.bind(component, old_wire, new_wire)
+        else:
+            self.bindings.resolve()
+            self._propagate_wire_update(component, old_wire, new_wire)
 
     def _propagate_wire_update(
         self, component: "Circuit", old_wire: Wire, new_wire: Wire
@@ -225,6 +293,41 @@ class Circuit:
                 wire_dict.update(updates)
                 self._propagate_wire_update(sub_components, old_wire, new_wire)
 
+    def __deepcopy__(self, memo: Dict[int, Any]) -> Self:
+        """Copy the circuit, its components, and its wires.
+
+        The generic deep copy spends most of its time introspecting the objects: the
+        dictionaries of the circuit are copied directly instead, the wires being new
+        wires as with 'Wire.__deepcopy__()'. A wire or component shared by several
+        ports is still shared by the copies, through the memo.
+        """
+        copy = type(self).__new__(type(self))
+        memo[id(self)] = copy
+        get = memo.get
+        state = self.__dict__.copy()
+        state["inputs"] = {
+            k: get(id(wire)) or wire.__deepcopy__(memo)
+            for k, wire in self.inputs.items()
+        }
+        state["outputs"] = {
+            k: get(id(wire)) or wire.__deepcopy__(memo)
+            for k, wire in self.outputs.items()
+        }
+        state["inputs_names"] = dict(self.inputs_names)
+        state["outputs_names"] = dict(self.outputs_names)
+        state["components"] = {
+            k: get(id(component)) or component.__deepcopy__(memo)
+            for k, component in self.components.items()
+        }
+        # The pending bindings refer to the wires of the original circuit.
+        state["bindings"] = None
+        # The attributes of the subclasses, e.g. 'DecodedCircuit'.
+        if type(self) is not Circuit:
+            for attribute in state.keys() - _CIRCUIT_ATTRIBUTES:
+                state[attribute] = deepcopy(state[attribute], memo)
+        copy.__dict__ = state
+        return copy
+
     def __str__(self, indent: int = 0):
         """Human-readable string representation of the Circuit with clear indentation.
         Shows basic information about the circuit structure in a compact format.
@@ -0,0 +1,364 @@
+from dataclasses import dataclass
+from typing import Dict, List, Optional, Sequence, Tuple
+
+from nand.circuit import Circuit, CircuitId, InputId, OutputId
+from nand.circuit_optimizer import topological_order
+from nand.circuits_library import CircuitLibrary, library_from_circuit
+from nand.wire import Wire
+
+
+@dataclass(frozen=True, slots=True)
+class ComponentInstance:
+    """A component of a circuit definition: a reference to a shared definition, and
+    the binding of its ports to the slots of the parent definition.
+
+    Attributes:
+        key: The identifier of the component in its parent.
+        definition: The definition of the component, shared by all its instances.
+        inputs: The slot of the parent read by each input of the component.
+        outputs_base: The first slot of the parent written by the component. Its
+                      outputs are the slots 'outputs_base' and following.
+    """
+
+    key: CircuitId
+    definition: "CircuitDefinition"
+    inputs: Tuple[int, ...]
+    outputs_base: int
+
+
+@dataclass(frozen=True, slots=True)
+class CircuitDefinition:
+    """An immutable definition of a circuit, shared by all its instances.
+
+    Contrary to a 'Circuit', a definition doesn't own any wire: the wires are local
+    "slots" numbered in the definition. The first slots are the inputs, then come the
+    outputs of each component, in order. A component is a reference to the definition
+    of its circuit, and the array of the slots its inputs are bound to.
+
+    So, a circuit used many times isn't copied: its definition exists once, whatever
+    the number of instances, and an instance costs a few integers. The state of the
+    wires isn't in the definition either, but in the flat buffer of a simulator (see
+    'flatten_definition()').
+
+    The components are in topological order.
+
+    Attributes:
+        identifier: Identifier of the circuit. 0 is reserved for the NAND gate, which
+                    is the only definition without components.
+        name: The name of the circuit.
+        inputs: The identifiers of the inputs, the i-th one being the slot i.
+        outputs: The identifiers of the outputs.
+        output_slots: The slot of each output.
+        components: The components, in topological order.
+        slots_count: The number of slots.
+    """
+
+    identifier: CircuitId
+    name: str
+    inputs: Tuple[InputId, ...]
+    outputs: Tuple[OutputId, ...]
+    output_slots: Tuple[int, ...]
+    components: Tuple[ComponentInstance, ...]
+    slots_count: int
+
+    @property
+    def is_nand(self) -> bool:
+        return self.identifier == 0
+
+
+NAND_DEFINITION = CircuitDefinition(
+    identifier=0,
+    name="NAND",
+    inputs=("A", "B"),
+    outputs=("OUT",),
+    output_slots=(2,),
+    components=(),
+    slots_count=3,
+)
+
+type CircuitDefinitions = Dict[CircuitId, CircuitDefinition]
+
+# The source of a port: '(-1, input index)' for an input of the circuit, or
+# '(component index, output index)' for an output of a component.
+type Source = Tuple[int, int]
+type ComponentBindings = Tuple[CircuitId, CircuitDefinition, Sequence[Source]]
+
+
+class DefinitionBuilder:
+    """Build a circuit definition from other definitions, with the same interface as
+    the 'Circuit' builder methods.
+
+    The components are not copied: a component is a reference to its definition.
+    The components can be added in any order, they are sorted when building.
+
+    Example:
+        builder = DefinitionBuilder("NOT")
+        builder.add_component("NAND", NAND_DEFINITION)
+        builder.connect_input("IN", "NAND", "A")
+        builder.connect_input("IN", "NAND", "B")
+        builder.connect_output("OUT", "NAND", "OUT")
+        not_definition = builder.build()
+    """
+
+    def __init__(self, identifier: CircuitId, name: Optional[str] = None):
+        self.identifier = identifier
+        self.name = str(identifier) if name is None else name
+        self._inputs: List[InputId] = []
+        self._outputs: Dict[OutputId, Source] = {}
+        self._keys: List[CircuitId] = []
+        self._definitions: List[CircuitDefinition] = []
+        # The source of each input of each component, None if not connected yet.
+        self._bindings: List[List[Optional[Source]]] = []
+        self._indices: Dict[CircuitId, int] = {}
+
+    def add_input(self, input_id: InputId):
+        """Declare an input without connecting it, to fix the order of the inputs."""
+        if input_id not in self._inputs:
+            self._inputs.append(input_id)
+
+    def add_component(self, key: CircuitId, definition: CircuitDefinition):
+        if key in self._indices:
+            raise ValueError(f"The component {key} already exists.")
+        self._indices[key] = len(self._keys)
+        self._keys.append(key)
+        self._definitions.append(definition)
+        self._bindings.append([None] * len(definition.inputs))
+
+    def connect_input(
+        self, input_id: InputId, target_id: CircuitId, target_input_id: InputId
+    ):
+        target, port = self._port(target_id, target_input_id, is_input=True)
+        self.add_input(input_id)
+        self._bindings[target][port] = (-1, self._inputs.index(input_id))
+
+    def connect_output(
+        self, output_id: OutputId, source_id: CircuitId, source_output_id: OutputId
+    ):
+        self._outputs[output_id] = self._port(
+            source_id, source_output_id, is_input=False
+        )
+
+    def connect(
+        self,
+        source_id: CircuitId,
+        source_output_id: OutputId,
+        target_id: CircuitId,
+        target_input_id: InputId,
+    ):
+        source = self._port(source_id, source_output_id, is_input=False)
+        target, port = self._port(target_id, target_input_id, is_input=True)
+        self._bindings[target][port] = source
+
+    def build(self) -> CircuitDefinition:
+        """Build the definition, with its components in topological order.
+
+        Raises:
+            ValueError: If an input of a component isn't connected, or if the
+            components have a cyclic dependency.
+        """
+        for key, bindings in zip(self._keys, self._bindings):
+            if None in bindings:
+                raise ValueError(f"An input of the component {key} isn't connected.")
+
+        return definition_from_bindings(
+            self.identifier,
+            self.name,
+            self._inputs,
+            list(zip(self._keys, self._definitions, self._bindings)),  # type: ignore
+            self._outputs,
+        )
+
+    def _port(
+        self, component_id: CircuitId, port_id: InputId | OutputId, is_input: bool
+    ) -> Source:
+        if component_id not in self._indices:
+            raise ValueError(f"The component {component_id} does not exist.")
+        idx = self._indices[component_id]
+        definition = self._definitions[idx]
+        ports = definition.inputs if is_input else definition.outputs
+        if port_id not in ports:
+            kind = "input" if is_input else "output"
+            raise ValueError(
+                f"The component {component_id} does not have {kind} wire {port_id}."
+            )
+        return idx, ports.index(port_id)
+
+
+def definition_from_bindings(
+    identifier: CircuitId,
+    name: str,
+    inputs: Sequence[InputId],
+    components: Sequence[ComponentBindings],
+    outputs: Dict[OutputId, Source],
+) -> CircuitDefinition:
+    """Build a definition from the sources of the ports, the components being in any
+    order.
+
+    Args:
+        identifier: The identifier of the circuit.
+        name: The name of the circuit.
+        inputs: The identifiers of the inputs.
+        components: The key, the definition, and the source of each input of each
+        component.
+        outputs: The source of each output.
+
+    Raises:
+        ValueError: If the components have a cyclic dependency.
+    """
+    sources = [
+        {component for component, _ in bindings if component >= 0}
+        for _, _, bindings in components
+    ]
+    order = topological_order(sources)
+    if len(order) != len(components):
+        raise ValueError(
+            f"The components of the circuit {identifier} have a cyclic dependency."
+        )
+
+    # The first output slot of each component, in the sorted order.
+    bases: Dict[int, int] = {}
+    slots_count = len(inputs)
+    for idx in order:
+        bases[idx] = slots_count
+        slots_count += len(components[idx][1].outputs)
+
+    def slot(source: Source) -> int:
+        component, port = source
+        return port if component < 0 else bases[component] + port
+
+    instances = tuple(
+        ComponentInstance(
+            key=components[idx][0],
+            definition=components[idx][1],
+            inputs=tuple(slot(source) for source in components[idx][2]),
+            outputs_base=bases[idx],
+        )
+        for idx in order
+    )
+    return CircuitDefinition(
+        identifier=identifier,
+        name=name,
+        inputs=tuple(inputs),
+        outputs=tuple(outputs.keys()),
+        output_slots=tuple(slot(source) for source in outputs.values()),
+        components=instances,
+        slots_count=slots_count,
+    )
+
+
+def definitions_from_library(library: CircuitLibrary) -> CircuitDefinitions:
+    """Convert all the circuits of a library into shared definitions.
+
+    The library circuits are expected to be built in dependency order, the components
+    of a circuit being defined before it, as the circuits built by 'CircuitBuilder'.
+
+    Returns:
+        The definitions, by circuit identifier, in the order of the library.
+    """
+    definitions: CircuitDefinitions = {0: NAND_DEFINITION}
+    for circuit in library.library.values():
+        if circuit.identifier not in definitions:
+            definitions[circuit.identifier] = _definition_from_circuit(
+                circuit, definitions
+            )
+    return definitions
+
+
+def definition_from_circuit(circuit: Circuit) -> CircuitDefinition:
+    """Convert a circuit into a definition, each circuit identifier being converted
+    once, from its first instance.
+
+    The components of each definition are sorted when it's built (see
+    'definition_from_bindings()'): the circuit isn't modified, and the instances of
+    an identifier already converted aren't walked.
+    """
+    definitions: CircuitDefinitions = {0: NAND_DEFINITION}
+    for sub_circuit in library_from_circuit(circuit).library.values():
+        if sub_circuit.identifier not in definitions:
+            definitions[sub_circuit.identifier] = _definition_from_circuit(
+                sub_circuit, definitions
+            )
+    return definitions[circuit.identifier]
+
+
+def _definition_from_circuit(
+    circuit: Circuit, definitions: CircuitDefinitions
+) -> CircuitDefinition:
+    """Convert a single circuit, its components' definitions being already known.
+
+    The sources are found from the wires directly: a circuit can have an output
+    connected to one of its inputs, which the builder methods can't express.
+    """
+    # The source of each wire of the circuit.
+    sources: Dict[int, Source] = {
+        wire.id: (-1, idx) for idx, wire in enumerate(circuit.inputs.values())
+    }
+    for idx, component in enumerate(circuit.components.values()):
+        if component.identifier not in definitions:
+            raise ValueError(
+                f"The circuit {component.identifier} is used by {circuit.identifier} "
+                f"before being defined."
+            )
+        for port, wire in enumerate(component.outputs.values()):
+            sources.setdefault(wire.id, (idx, port))
+
+    components = [
+        (
+            key,
+            definitions[component.identifier],
+            [_source(wire, sources) for wire in component.inputs.values()],
+        )
+        for key, component in circuit.components.items()
+    ]
+    outputs = {
+        output_id: _source(wire, sources)
+        for output_id, wire in circuit.outputs.items()
+    }
+    return definition_from_bindings(
+        circuit.identifier, circuit.name, list(circuit.inputs), components, outputs
+    )
+
+
+def _source(wire: Wire, sources: Dict[int, Source]) -> Source:
+    if wire.id not in sources:
+        raise ValueError(
+            f"Wire {wire.id} is read before being driven: "
+            f"the circuit has a missing connection."
+        )
+    return sources[wire.id]
+
+
+def definition_to_circuit(
+    definition: CircuitDefinition, inputs: Optional[Sequence[Wire]] = None
+) -> Circuit:
+    """Expand a definition back into a tree of circuits, e.g. to encode it.
+
+    Args:
+        definition: The definition to expand.
+        inputs: The wires to use as inputs of the circuit, new wires by default.
+
+    Returns:
+        A new circuit, with its own wires.
+    """
+    circuit = Circuit(definition.identifier)
+    circuit.name = definition.name
+
+    slots: List[Wire] = list(inputs) if inputs is not None else []
+    slots += [Wire() for _ in range(len(definition.inputs) - len(slots))]
+    for input_id, wire in zip(definition.inputs, slots):
+        circuit.inputs[input_id] = wire
+        circuit.inputs_names[input_id] = str(input_id)
+
+    if definition.is_nand:
+        slots.append(Wire())
+    for component in definition.components:
+        sub_circuit = definition_to_circuit(
+            component.definition, [slots[idx] for idx in component.inputs]
+        )
+        circuit.add_component(component.key, sub_circuit)
+        slots.extend(sub_circuit.outputs.values())
+
+    for output_id, idx in zip(definition.outputs, definition.output_slots):
+        circuit.outputs[output_id] = slots[idx]
+        circuit.outputs_names[output_id] = str(output_id)
+    return circuit
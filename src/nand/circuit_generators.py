@@ -0,0 +1,452 @@
+from copy import deepcopy
+from typing import List, Optional, Sequence, Tuple
+
+from nand.circuit import Circuit, CircuitId, InputId, OutputId
+from nand.circuits_library import CircuitBuilder, CircuitLibrary
+from nand.wire import Wire
+
+# The source of a signal: '(None, input id)' for an input of the circuit, or
+# '(component key, output id)' for an output of a component.
+type Signal = Tuple[Optional[CircuitId], InputId | OutputId]
+
+
+def default_library() -> CircuitLibrary:
+    """The library of 'CircuitBuilder', whose gates are used by the generators."""
+    builder = CircuitBuilder()
+    builder.build_circuits()
+    return builder.library
+
+
+class _Generator:
+    """Build a circuit one level deep, from the gates of a library.
+
+    Every gate is a direct component of the generated circuit, so each connection
+    only updates the wires of a small component: the construction is linear in the
+    number of gates, whatever the size of the circuit. The generators build the
+    circuit inside its 'Circuit.deferred_wiring()' context:
+
+        generator = _Generator(identifier, inputs, library)
+        with generator.circuit.deferred_wiring():
+            ...
+        return generator.circuit
+    """
+
+    def __init__(
+        self,
+        identifier: CircuitId,
+        inputs: Sequence[InputId],
+        library: Optional[CircuitLibrary],
+    ):
+        self.library = default_library() if library is None else library
+        self.circuit = Circuit(identifier)
+        # The inputs are declared first, to be in the given order.
+        for input_id in inputs:
+            self.circuit.inputs[input_id] = Wire()
+            self.circuit.inputs_names[input_id] = str(input_id)
+        self._zero: Optional[Signal] = None
+
+    def gate(
+        self, circuit: CircuitId | Circuit, *signals: Optional[Signal]
+    ) -> CircuitId:
+        """Add a component, its inputs connected to the signals, in order.
+
+        Args:
+            circuit: The identifier of a circuit of the library, or the component
+            itself.
+            signals: The signal of each input, or None to connect it later, e.g. to
+            close a feedback loop.
+
+        Returns:
+            The key of the component.
+        """
+        if isinstance(circuit, Circuit):
+            component = circuit
+        else:
+            component = self.library.get_circuit(circuit)
+        key = len(self.circuit.components)
+        self.circuit.add_component(key, component)
+        if len(signals) != len(component.inputs):
+            raise ValueError(
+                f"The circuit {component.identifier} has {len(component.inputs)} "
+                f"inputs, not {len(signals)}."
+            )
+        for signal, input_id in zip(signals, component.inputs):
+            if signal is not None:
+                self.connect(signal, key, input_id)
+        return key
+
+    def output(
+        self, circuit: CircuitId | Circuit, *signals: Optional[Signal]
+    ) -> Signal:
+        """Add a single output gate, and return its output."""
+        key = self.gate(circuit, *signals)
+        output_id = next(iter(self.circuit.components[key].outputs))
+        return key, output_id
+
+    def connect(self, signal: Signal, key: CircuitId, input_id: InputId):
+        source, port = signal
+        if source is None:
+            self.circuit.connect_input(port, key, input_id)
+        else:
+            self.circuit.connect(source, port, key, input_id)
+
+    def connect_output(self, output_id: OutputId, signal: Signal):
+        source, port = signal
+        if source is None:
+            raise ValueError(f"The output {output_id} can't be an input.")
+        self.circuit.connect_output(output_id, source, port)
+
+    def zero(self) -> Signal:
+        """The constant 0, from the first input: 'x AND NOT x'."""
+        if self._zero is None:
+            first: Signal = (None, next(iter(self.circuit.inputs)))
+            self._zero = self.output("AND", first, self.output("NOT", first))
+        return self._zero
+
+    def half_adder(self, a: Signal, b: Signal) -> Tuple[Signal, Signal]:
+        key = self.gate("Half-Adder", a, b)
+        return (key, "SUM"), (key, "CARRY")
+
+    def full_adder(self, a: Signal, b: Signal, c: Signal) -> Tuple[Signal, Signal]:
+        key = self.gate("Full-Adder", a, b, c)
+        return (key, "SUM"), (key, "Cout")
+
+
+def _input(input_id: InputId) -> Signal:
+    return None, input_id
+
+
+def _adder_inputs(bits: int) -> List[InputId]:
+    """The inputs of the adders, in the order of 'CircuitBuilder' adders."""
+    inputs: List[InputId] = ["A0", "B0", "C0"]
+    for bit in range(1, bits):
+        inputs += [f"A{bit}", f"B{bit}"]
+    return inputs
+
+
+def _check_bits(bits: int, minimum: int = 1):
+    if bits < minimum:
+        raise ValueError(f"The number of bits must be at least {minimum}.")
+
+
+def ripple_carry_adder(bits: int, library: Optional[CircuitLibrary] = None) -> Circuit:
+    """An adder of two 'bits' bits numbers, made of a chain of full adders.
+
+    The ports are the same as the adders of 'CircuitBuilder': the inputs are 'A0',
+    'B0', the carry 'C0', then 'A1', 'B1', etc. The outputs are 'S0' to 'S<bits-1>',
+    and the carry 'Cout'.
+
+    Args:
+        bits: The number of bits of the numbers to add.
+        library: The library of the gates, 'CircuitBuilder' one by default.
+    """
+    _check_bits(bits)
+    generator = _Generator(
+        f"{bits}-Bits Ripple-Carry Adder", _adder_inputs(bits), library
+    )
+    with generator.circuit.deferred_wiring():
+        carry = _input("C0")
+        for bit in range(bits):
+            total, carry = generator.full_adder(
+                _input(f"A{bit}"), _input(f"B{bit}"), carry
+            )
+            generator.connect_output(f"S{bit}", total)
+        generator.connect_output("Cout", carry)
+    return generator.circuit
+
+
+def carry_lookahead_adder(
+    bits: int, library: Optional[CircuitLibrary] = None
+) -> Circuit:
+    """An adder computing all its carries in parallel, with a Kogge-Stone prefix tree.
+
+    Each bit generates a carry ('A AND B'), or propagates the previous one
+    ('A XOR B'). The carries are the prefixes of the (generate, propagate) pairs,
+    computed in 'log2(bits)' levels: the depth is logarithmic, for 'bits * log2(bits)'
+    gates.
+
+    The ports are the same as 'ripple_carry_adder()'.
+    """
+    _check_bits(bits)
+    generator = _Generator(
+        f"{bits}-Bits Carry-Lookahead Adder", _adder_inputs(bits), library
+    )
+    with generator.circuit.deferred_wiring():
+        propagates = [
+            generator.output("XOR", _input(f"A{bit}"), _input(f"B{bit}"))
+            for bit in range(bits)
+        ]
+        generates = [
+            generator.output("AND", _input(f"A{bit}"), _input(f"B{bit}"))
+            for bit in range(bits)
+        ]
+
+        # The prefix i is the carry into the bit i, and whether the bits before
+        # propagate the carry input. The carry input itself is the prefix 0, and never
+        # propagates anything: its propagate is None.
+        prefix_generates: List[Signal] = [_input("C0")] + generates
+        prefix_propagates: List[Optional[Signal]] = [None] + list(propagates)
+        distance = 1
+        while distance <= bits:
+            next_generates = list(prefix_generates)
+            next_propagates = list(prefix_propagates)
+            for idx in range(distance, bits + 1):
+                propagate = prefix_propagates[idx]
+                if propagate is None:
+                    continue
+                # (G, P) o (G', P') = (G OR (P AND G'), P AND P')
+                carried = generator.output(
+                    "AND", propagate, prefix_generates[idx - distance]
+                )
+                next_generates[idx] = generator.output(
+                    "OR", prefix_generates[idx], carried
+                )
+                previous = prefix_propagates[idx - distance]
+                if previous is not None:
+                    previous = generator.output("AND", propagate, previous)
+                next_propagates[idx] = previous
+            prefix_generates, prefix_propagates = next_generates, next_propagates
+            distance *= 2
+
+        for bit in range(bits):
+            total = generator.output("XOR", propagates[bit], prefix_generates[bit])
+            generator.connect_output(f"S{bit}", total)
+        generator.connect_output("Cout", prefix_generates[bits])
+    return generator.circuit
+
+
+def array_multiplier(bits: int, library: Optional[CircuitLibrary] = None) -> Circuit:
+    """A multiplier of two 'bits' bits numbers: the partial products 'Ai AND Bj'
+    are summed row by row, by ripple-carry adders.
+
+    The inputs are 'A0' to 'A<bits-1>', then 'B0' to 'B<bits-1>'. The outputs are
+    the '2 * bits' bits of the product, 'P0' to 'P<2*bits-1>'.
+    """
+    _check_bits(bits)
+    inputs = [f"A{bit}" for bit in range(bits)] + [f"B{bit}" for bit in range(bits)]
+    generator = _Generator(f"{bits}x{bits} Array Multiplier", inputs, library)
+
+    def partial_product(a: int, b: int) -> Signal:
+        return generator.output("AND", _input(f"A{a}"), _input(f"B{b}"))
+
+    with generator.circuit.deferred_wiring():
+        # The bits of the sum of the rows so far, from the least significant one.
+        accumulator: List[Signal] = [partial_product(a, 0) for a in range(bits)]
+        for b in range(1, bits):
+            carry: Optional[Signal] = None
+            for a in range(bits):
+                position = a + b
+                product = partial_product(a, b)
+                operands = [product]
+                if position < len(accumulator):
+                    operands.append(accumulator[position])
+                if carry is not None:
+                    operands.append(carry)
+                if len(operands) == 3:
+                    total, carry = generator.full_adder(*operands)
+                elif len(operands) == 2:
+                    total, carry = generator.half_adder(*operands)
+                else:
+                    total, carry = product, None
+                if position < len(accumulator):
+                    accumulator[position] = total
+                else:
+                    accumulator.append(total)
+            if carry is not None:
+                accumulator.append(carry)
+
+        while len(accumulator) < 2 * bits:
+            accumulator.append(generator.zero())
+        for position, signal in enumerate(accumulator):
+            generator.connect_output(f"P{position}", signal)
+    return generator.circuit
+
+
+def comparator(bits: int, library: Optional[CircuitLibrary] = None) -> Circuit:
+    """A comparator of two unsigned 'bits' bits numbers.
+
+    The bits are compared from the least significant one: 'A' is greater than 'B'
+    on the bits 0 to i if it is on the bit i, or if the bits i are equal and it is
+    on the bits 0 to i-1.
+
+    The inputs are 'A0' to 'A<bits-1>', then 'B0' to 'B<bits-1>'. The outputs are
+    'LT', 'EQ', and 'GT'.
+    """
+    _check_bits(bits)
+    inputs = [f"A{bit}" for bit in range(bits)] + [f"B{bit}" for bit in range(bits)]
+    generator = _Generator(f"{bits}-Bits Comparator", inputs, library)
+    with generator.circuit.deferred_wiring():
+
+        less: Optional[Signal] = None
+        equal: Optional[Signal] = None
+        greater: Optional[Signal] = None
+        for bit in range(bits):
+            a, b = _input(f"A{bit}"), _input(f"B{bit}")
+            bit_less = generator.output("AND", generator.output("NOT", a), b)
+            bit_greater = generator.output("AND", a, generator.output("NOT", b))
+            bit_equal = generator.output("NOR", bit_less, bit_greater)
+            if less is None or equal is None or greater is None:
+                less, equal, greater = bit_less, bit_equal, bit_greater
+                continue
+            less = generator.output(
+                "OR", bit_less, generator.output("AND", bit_equal, less)
+            )
+            greater = generator.output(
+                "OR", bit_greater, generator.output("AND", bit_equal, greater)
+            )
+            equal = generator.output("AND", bit_equal, equal)
+
+        assert less is not None and equal is not None and greater is not None
+        generator.connect_output("LT", less)
+        generator.connect_output("EQ", equal)
+        generator.connect_output("GT", greater)
+    return generator.circuit
+
+
+def multiplexer_tree(
+    select_bits: int, library: Optional[CircuitLibrary] = None
+) -> Circuit:
+    """A multiplexer of '2 ** select_bits' inputs, as a tree of 2:1 multiplexers.
+
+    The inputs are the select bits 'S0' to 'S<select_bits-1>', the least significant
+    first, then the data 'D0' to 'D<2**select_bits-1>'. The output 'OUT' is the
+    data whose index are the select bits.
+    """
+    _check_bits(select_bits)
+    count = 1 << select_bits
+    inputs = [f"S{bit}" for bit in range(select_bits)] + [
+        f"D{idx}" for idx in range(count)
+    ]
+    generator = _Generator(f"{count}:1 Multiplexer", inputs, library)
+    with generator.circuit.deferred_wiring():
+
+        signals: List[Signal] = [_input(f"D{idx}") for idx in range(count)]
+        for bit in range(select_bits):
+            select = _input(f"S{bit}")
+            not_select = generator.output("NOT", select)
+            signals = [
+                generator.output(
+                    "OR",
+                    generator.output("AND", low, not_select),
+                    generator.output("AND", high, select),
+                )
+                for low, high in zip(signals[::2], signals[1::2])
+            ]
+        generator.connect_output("OUT", signals[0])
+    return generator.circuit
+
+
+def d_latch(library: Optional[CircuitLibrary] = None) -> Circuit:
+    """A gated D latch: 'Q' follows 'D' while 'EN' is 1, and holds its value while
+    'EN' is 0.
+
+    The memory is a feedback loop between two NAND gates, so the latch can only be
+    simulated by 'SimulatorSequential'. The inputs are 'D' and 'EN', the outputs
+    'Q' and 'NQ', its inverse.
+    """
+    generator = _Generator("D-Latch", ["D", "EN"], library)
+    with generator.circuit.deferred_wiring():
+        d, enable = _input("D"), _input("EN")
+        set_n = generator.output(0, d, enable)
+        reset_n = generator.output(0, generator.output("NOT", d), enable)
+        q = generator.gate(0, set_n, None)
+        nq = generator.gate(0, reset_n, (q, "OUT"))
+        generator.connect((nq, "OUT"), q, "B")
+        generator.connect_output("Q", (q, "OUT"))
+        generator.connect_output("NQ", (nq, "OUT"))
+    return generator.circuit
+
+
+def d_flip_flop(library: Optional[CircuitLibrary] = None) -> Circuit:
+    """A D flip-flop, triggered by the rising edge of the clock.
+
+    Two D latches: the master one follows 'D' while 'CLK' is 0, and the slave one
+    outputs the master one while 'CLK' is 1. So, 'Q' takes the value of 'D' when
+    'CLK' goes from 0 to 1. The inputs are 'D' and 'CLK', the outputs 'Q' and 'NQ'.
+    """
+    generator = _Generator("D-Flip-Flop", ["D", "CLK"], library)
+    with generator.circuit.deferred_wiring():
+        clock = _input("CLK")
+        master = generator.gate(
+            d_latch(generator.library), _input("D"), generator.output("NOT", clock)
+        )
+        slave = generator.gate(d_latch(generator.library), (master, "Q"), clock)
+        generator.connect_output("Q", (slave, "Q"))
+        generator.connect_output("NQ", (slave, "NQ"))
+    return generator.circuit
+
+
+def register(bits: int, library: Optional[CircuitLibrary] = None) -> Circuit:
+    """A register of 'bits' D flip-flops sharing the same clock.
+
+    The inputs are 'D0' to 'D<bits-1>', then 'CLK'. The outputs are 'Q0' to
+    'Q<bits-1>'.
+    """
+    _check_bits(bits)
+    inputs = [f"D{bit}" for bit in range(bits)] + ["CLK"]
+    generator = _Generator(f"{bits}-Bits Register", inputs, library)
+    with generator.circuit.deferred_wiring():
+        flip_flop = d_flip_flop(generator.library)
+        for bit in range(bits):
+            key = generator.gate(deepcopy(flip_flop), _input(f"D{bit}"), _input("CLK"))
+            generator.connect_output(f"Q{bit}", (key, "Q"))
+    return generator.circuit
+
+
+def accumulator(bits: int, library: Optional[CircuitLibrary] = None) -> Circuit:
+    """A register adding its input to its value at each rising edge of the clock:
+    'Q <- Q + X', modulo '2 ** bits'. A minimal datapath: a register, and an adder in
+    its feedback loop.
+
+    The inputs are 'X0' to 'X<bits-1>', then 'CLK'. The outputs are 'Q0' to
+    'Q<bits-1>'. The value at power-on is arbitrary.
+    """
+    _check_bits(bits)
+    inputs = [f"X{bit}" for bit in range(bits)] + ["CLK"]
+    generator = _Generator(f"{bits}-Bits Accumulator", inputs, library)
+    with generator.circuit.deferred_wiring():
+        flip_flop = d_flip_flop(generator.library)
+        flip_flops = [
+            generator.gate(deepcopy(flip_flop), None, _input("CLK"))
+            for _ in range(bits)
+        ]
+        carry = generator.zero()
+        for bit in range(bits):
+            total, carry = generator.full_adder(
+                (flip_flops[bit], "Q"), _input(f"X{bit}"), carry
+            )
+            generator.connect(total, flip_flops[bit], "D")
+            generator.connect_output(f"Q{bit}", (flip_flops[bit], "Q"))
+    return generator.circuit
+
+
+def nand_network(
+    identifier: CircuitId,
+    inputs: Sequence[InputId],
+    gates: Sequence[Tuple[int, int]],
+    output: int,
+    library: Optional[CircuitLibrary] = None,
+) -> Circuit:
+    """A single output circuit of NAND gates, e.g. one found by 'nand.nand_search'.
+
+    The signals are numbered: first the inputs, then the output of each gate. The
+    output of the circuit is 'OUT'.
+
+    Args:
+        identifier: The identifier of the circuit.
+        inputs: The identifiers of the inputs.
+        gates: The two signals read by each gate, in topological order.
+        output: The signal of the output.
+    """
+    generator = _Generator(identifier, inputs, library)
+    with generator.circuit.deferred_wiring():
+        signals: List[Signal] = [_input(input_id) for input_id in inputs]
+        for a, b in gates:
+            signals.append(generator.output(0, signals[a], signals[b]))
+        if output < len(inputs):
+            # An input can't be an output: it goes through a double inversion.
+            inverted = generator.output("NOT", signals[output])
+            signals.append(generator.output("NOT", inverted))
+            output = len(signals) - 1
+        generator.connect_output("OUT", signals[output])
+    return generator.circuit
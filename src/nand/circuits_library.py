@@ -1,5 +1,5 @@
 from copy import deepcopy
-from typing import OrderedDict
+from typing import OrderedDict, Set
 
 from nand.circuit import Circuit, CircuitDict, CircuitId
 from nand.wire import Wire
@@ -34,6 +34,60 @@ class CircuitLibrary:
         return deepcopy(circuit)
 
 
+def library_from_circuit(circuit: Circuit) -> CircuitLibrary:
+    """Build the library of the circuits used by a circuit, the circuit included.
+
+    Each identifier is defined by the first instance found whose inputs are distinct
+    wires: when several inputs of an instance are the same wire, which internal port
+    belongs to which input is lost. The circuits are added in dependency order: the
+    NAND gate first, and each circuit after its components, as expected by the
+    encoders.
+
+    The circuits aren't copied: the library must only be read.
+
+    Args:
+        circuit: The top-level circuit.
+
+    Returns:
+        A library whose last circuit is 'circuit'.
+    """
+    definitions: CircuitDict = OrderedDict()
+
+    # The identifiers only defined by instances with some inputs on the same wire.
+    aliased: Set[CircuitId] = set()
+
+    def collect(component: Circuit):
+        identifier = component.identifier
+        if identifier in definitions and identifier not in aliased:
+            return
+        for sub_component in component.components.values():
+            collect(sub_component)
+
+        ids = {wire.id for wire in component.inputs.values()}
+        if len(ids) == len(component.inputs):
+            aliased.discard(identifier)
+        elif identifier in definitions:
+            return
+        else:
+            aliased.add(identifier)
+        # Replacing a definition keeps its position, after its components.
+        definitions[identifier] = component
+
+    collect(circuit)
+
+    library = CircuitLibrary()
+    # The NAND gate must be the first circuit, even if it isn't used.
+    if 0 in definitions:
+        library.add_circuit(definitions.pop(0))
+    else:
+        nand_builder = CircuitBuilder()
+        nand_builder.add_nand()
+        library.add_circuit(nand_builder.library.library[0])
+    for definition in definitions.values():
+        library.add_circuit(definition)
+    return library
+
+
 class CircuitBuilder:
     def __init__(self):
         self.library = CircuitLibrary()
@@ -1,5 +1,6 @@
 from bitarray import bitarray
 
+from nand.bits_utils import BitReader
 from nand.circuit import Circuit
 from nand.circuit_decoder import CircuitDecoder
 from nand.decoded_circuit import (
@@ -38,16 +39,17 @@ class DefaultDecoder(CircuitDecoder):
 
     def decode(self, data: bitarray) -> CircuitLibrary:
         """Decode the data into circuits."""
-        self.data = list(data.tobytes())
+        self.data = BitReader(data)
 
-        while len(self.data) != 0:
+        while not self.data.at_end():
             # The index is used as the identifier of the circuit
             self.idx += 1
             # The current circuit being decoded
             self.circuit = DecodedCircuit(self.idx)
             self._decode_circuit()
-            self.circuit.apply_inputs()
-            self.circuit.apply_connections()
+            with self.circuit.deferred_wiring():
+                self.circuit.apply_inputs()
+                self.circuit.apply_connections()
             self.library.add_circuit(self.circuit)
         return self.library
 
@@ -60,13 +62,13 @@ class DefaultDecoder(CircuitDecoder):
 
     def _decode_header(self):
         """Decode the header of the current circuit."""
-        self.circuit.components_count = self.data.pop(0)
-        self.circuit.inputs_count = self.data.pop(0)
-        self.circuit.outputs_count = self.data.pop(0)
+        self.circuit.components_count = self.data.read_byte()
+        self.circuit.inputs_count = self.data.read_byte()
+        self.circuit.outputs_count = self.data.read_byte()
 
     def _decode_component(self, component_idx: int):
         """Decode the 'component_idx'-th component of the circuit."""
-        circuit_id = self.data.pop(0)
+        circuit_id = self.data.read_byte()
         try:
             component = self.library.get_circuit(circuit_id)
         except ValueError as e:
@@ -81,7 +83,7 @@ class DefaultDecoder(CircuitDecoder):
         of the circuit.
         """
         for input_idx in range(0, len(component.inputs)):
-            provenance = self.data.pop(0)
+            provenance = self.data.read_byte()
             if provenance == 0:
                 self._decode_circuit_provenance(input_idx, component_idx)
             elif provenance == 1:
@@ -96,7 +98,7 @@ class DefaultDecoder(CircuitDecoder):
         """Decode the 'input_idx'-th input of the 'component_idx'-th component of the
         circuit, originating from the circuit's inputs.
         """
-        circuit_input_idx = self.data.pop(0)
+        circuit_input_idx = self.data.read_byte()
         if circuit_input_idx >= self.circuit.inputs_count:
             raise ValueError(
                 f"Circuit {self.circuit.identifier}: the {component_idx}-th component "
@@ -150,7 +152,7 @@ class DefaultDecoder(CircuitDecoder):
         """Decode the wiring between components: the component index
         and its output index.
         """
-        source_idx = self.data.pop(0)
+        source_idx = self.data.read_byte()
 
         if source_idx >= self.circuit.components_count:
             raise ValueError(
@@ -158,6 +160,6 @@ class DefaultDecoder(CircuitDecoder):
                 f"(there is {self.circuit.components_count} components)."
             )
 
-        source_output_idx = self.data.pop(0)
+        source_output_idx = self.data.read_byte()
 
         return (source_idx, source_output_idx)
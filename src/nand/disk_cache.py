@@ -0,0 +1,56 @@
+import hashlib
+import os
+import tempfile
+from pathlib import Path
+
+from bitarray import bitarray
+
+# The environment variable overriding the root directory of the caches.
+CACHE_DIR_ENV = "NAND_CACHE_DIR"
+
+
+def cache_directory(name: str) -> Path:
+    """Get a cache directory, creating it if needed.
+
+    The root directory is '$NAND_CACHE_DIR' if defined, otherwise 'nand' in the user
+    cache directory ('$XDG_CACHE_HOME', or '~/.cache').
+
+    Args:
+        name: The name of the cache, i.e. the sub-directory of the root directory.
+    """
+    root = os.environ.get(CACHE_DIR_ENV)
+    if root is None:
+        xdg_cache = os.environ.get("XDG_CACHE_HOME")
+        base = Path(xdg_cache) if xdg_cache else Path.home() / ".cache"
+        root = str(base / "nand")
+    directory = Path(root) / name
+    directory.mkdir(parents=True, exist_ok=True)
+    return directory
+
+
+def hash_bits(bits: bitarray, salt: str = "") -> str:
+    """Hash a bit stream into a cache key.
+
+    The length is hashed too, as the padding of the last byte is lost by 'tobytes()'.
+
+    Args:
+        bits: The bit stream to hash, usually an encoded circuit library.
+        salt: Distinguishes the keys of different formats built from the same stream.
+    """
+    digest = hashlib.sha256()
+    digest.update(salt.encode())
+    digest.update(len(bits).to_bytes(8, "little"))
+    digest.update(bits.tobytes())
+    return digest.hexdigest()
+
+
+def write_atomically(path: Path, data: bytes):
+    """Write a file so that concurrent readers never see it partially written."""
+    fd, tmp_path = tempfile.mkstemp(dir=path.parent, prefix=f".{path.name}.")
+    try:
+        with os.fdopen(fd, "wb") as file:
+            file.write(data)
+        os.replace(tmp_path, path)
+    except BaseException:
+        os.unlink(tmp_path)
+        raise
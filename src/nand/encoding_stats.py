@@ -1,38 +1,138 @@
-from typing import List, Tuple
+from time import perf_counter
+from typing import Callable, List, Optional, Sequence, Tuple, Type
+
+from nand.circuit_decoder import CircuitDecoder
 from nand.circuit_encoder import CircuitEncoder
 from nand.circuits_library import CircuitLibrary
 
 type Length = int
 type Percentage = float
-type EncodingStats = Tuple[Length, Percentage]
+# The number of circuits, or components for a large library, encoded or decoded per
+# second, None if not measured.
+type Throughput = Optional[float]
+type EncodingStats = Tuple[Length, Percentage, Throughput, Throughput, Throughput]
+
 
+def compare_encoders(
+    encoders: List[CircuitEncoder],
+    library: CircuitLibrary,
+    decoders: Optional[Sequence[Optional[Type[CircuitDecoder]]]] = None,
+    repeats: int = 5,
+    large_library: Optional[CircuitLibrary] = None,
+) -> None:
+    """Compare the encoders and print the encoding stats.
 
-def compare_encoders(encoders: List[CircuitEncoder], library: CircuitLibrary) -> None:
-    """Compare the encoders and print the encoding stats."""
-    encoding_stats = _compute_stats(encoders, library)
+    Args:
+        encoders: The encoders to compare.
+        library: The library to encode.
+        decoders: The decoder of each encoder, to measure the decoding throughput.
+        None for an encoder without decoder.
+        repeats: The number of encodings and decodings to measure the throughput.
+        large_library: A library of large circuits, e.g. the one of a generated
+        circuit (see 'nand.circuit_generators'), to also measure the decoding
+        throughput in components per second. Not measured for the encoders that
+        can't encode it.
+    """
+    encoding_stats = _compute_stats(
+        encoders, library, decoders, repeats, large_library
+    )
 
     max_width = max(len(encoder.__class__.__name__) for encoder in encoders)
 
     # Add some padding (e.g., 2 spaces) to make it look nicer
     name_width = max_width + 2
 
-    for encoder, length in encoding_stats:
+    for encoder, stats in encoding_stats:
+        length, percentage, encoding, decoding, large_decoding = stats
+        large = ""
+        if large_library is not None:
+            large = f"  large decode {_format_throughput(large_decoding, 'components')}"
         print(
-            f"{encoder.__class__.__name__:<{name_width}} {length[0]:>4} bits  ({length[1]:>6.2f}%) {'.' * int(length[0] // 32)}"
+            f"{encoder.__class__.__name__:<{name_width}} {length:>4} bits  "
+            f"({percentage:>6.2f}%)  encode {_format_throughput(encoding)}  "
+            f"decode {_format_throughput(decoding)}{large} "
+            f"{'.' * int(length // 32)}"
         )
 
 
-def _compute_stats(encoders: List[CircuitEncoder], library: CircuitLibrary):
-    length_stats: List[Tuple[CircuitEncoder, Length]] = []
-    for encoder in encoders:
+def _compute_stats(
+    encoders: List[CircuitEncoder],
+    library: CircuitLibrary,
+    decoders: Optional[Sequence[Optional[Type[CircuitDecoder]]]] = None,
+    repeats: int = 5,
+    large_library: Optional[CircuitLibrary] = None,
+) -> List[Tuple[CircuitEncoder, EncodingStats]]:
+    if decoders is None:
+        decoders = [None] * len(encoders)
+    if len(decoders) != len(encoders):
+        raise ValueError("There must be one decoder, or None, per encoder.")
+    circuits_count = len(library.library) - 1
+
+    length_stats: List[
+        Tuple[CircuitEncoder, Length, Throughput, Throughput, Throughput]
+    ] = []
+    for encoder, decoder in zip(encoders, decoders):
         encoding = encoder.encode(library)
-        length = len(encoding)
-        length_stats.append((encoder, length))
+        # An encoder or a decoder is used once, as they keep the state of the last
+        # encoding or decoding.
+        encoding_time = _measure(lambda: type(encoder)().encode(library), repeats)
+        decoding_time = None
+        large_decoding = None
+        if decoder is not None:
+            decoding_time = _measure(lambda: decoder().decode(encoding), repeats)
+            if large_library is not None:
+                large_decoding = _measure_large_decoding(
+                    type(encoder), decoder, large_library, repeats
+                )
+        length_stats.append(
+            (
+                encoder,
+                len(encoding),
+                circuits_count / encoding_time,
+                None if decoding_time is None else circuits_count / decoding_time,
+                large_decoding,
+            )
+        )
     length_stats.sort(key=lambda x: -x[1])
 
     encoding_stats: List[Tuple[CircuitEncoder, EncodingStats]] = []
-    for encoder, length in length_stats:
+    for encoder, length, *throughputs in length_stats:
         percentage = length / length_stats[0][1] * 100
-        encoding_stats.append((encoder, (length, percentage)))
+        encoding_stats.append((encoder, (length, percentage, *throughputs)))
 
     return encoding_stats
+
+
+def _measure_large_decoding(
+    encoder: Type[CircuitEncoder],
+    decoder: Type[CircuitDecoder],
+    library: CircuitLibrary,
+    repeats: int,
+) -> Throughput:
+    """The number of components decoded per second from a large library, None if
+    the encoder can't encode it."""
+    try:
+        encoding = encoder().encode(library)
+    except OverflowError:
+        # The counts of 'DefaultEncoder' are a single byte.
+        return None
+    components_count = sum(
+        len(circuit.components) for circuit in library.library.values()
+    )
+    return components_count / _measure(lambda: decoder().decode(encoding), repeats)
+
+
+def _measure(function: Callable[[], object], repeats: int) -> float:
+    """The best time of a few calls of a function, in seconds."""
+    best = float("inf")
+    for _ in range(max(1, repeats)):
+        start = perf_counter()
+        function()
+        best = min(best, perf_counter() - start)
+    return best
+
+
+def _format_throughput(throughput: Throughput, unit: str = "circuits") -> str:
+    if throughput is None:
+        return f"{'-':>9} {unit}/s"
+    return f"{throughput:>9.0f} {unit}/s"
@@ -0,0 +1,165 @@
+from typing import List
+
+from bitarray import bitarray
+
+from nand.bits_utils import bitlength_with_offset
+from nand.circuit_decoder import CircuitDecoder
+from nand.circuits_library import CircuitLibrary
+from nand.decoded_circuit import (
+    ConnectionParameters,
+    DecodedCircuit,
+    InputParameters,
+)
+from nand.entropy_encoder import MAX_INPUT_CONTEXT, EntropyModels
+from nand.range_coder import RangeDecoder
+
+
+class EntropyDecoder(CircuitDecoder):
+    """
+    Decode the output of 'EntropyEncoder' into circuits.
+
+    The models are adapted exactly as during the encoding, so each field is decoded
+    with the same probabilities it was encoded with. As with 'BitPackedDecoder', the
+    circuits, inputs, and outputs are identified by their index.
+
+    Each field is decoded bit by bit, a range coder step per bit, where
+    'BitPackedDecoder' slices a whole field at once: the fields are slower to decode,
+    but the decoding is dominated by the copies of the components anyway.
+
+    'EntropyEncoder' comments are the source of truth, so this class is voluntarily
+    less commented.
+    """
+
+    def __init__(self):
+        self.library = CircuitLibrary()
+        self.library.add_circuit(self._build_nand())
+
+    def decode(self, data: bitarray) -> CircuitLibrary:
+        """Decode the data into circuits."""
+        self.coder = RangeDecoder(data.tobytes())
+        self.models = EntropyModels()
+        self.outputs_counts: List[int] = [1]
+        self.max_outputs = 1
+
+        circuits_count = self.models.circuits_count.decode(self.coder)
+        for idx in range(1, circuits_count + 1):
+            circuit = self._decode_circuit(idx)
+            with circuit.deferred_wiring():
+                circuit.apply_inputs()
+                circuit.apply_connections()
+            self.library.add_circuit(circuit)
+            self.outputs_counts.append(circuit.outputs_count)
+            self.max_outputs = max(self.max_outputs, circuit.outputs_count)
+        return self.library
+
+    def _decode_circuit(self, idx: int) -> DecodedCircuit:
+        models = self.models
+        self.circuit = DecodedCircuit(idx)
+        self.circuit.components_count = models.components_count.decode(self.coder)
+        self.circuit.inputs_count = models.inputs_count.decode(self.coder)
+        self.circuit.outputs_count = models.outputs_count.decode(self.coder)
+
+        self.components_ids: List[int] = []
+        self.last_input = -1
+        self.provenance = 0
+        was_same = 0
+        for component_idx in range(self.circuit.components_count):
+            was_same = self._decode_component_circuit(idx, component_idx, was_same)
+            component = self.library.get_circuit(self.components_ids[-1])
+            self.circuit.add_component(component_idx, component)
+            self._decode_inputs(component_idx, len(component.inputs))
+
+        for output_idx in range(self.circuit.outputs_count):
+            source_idx, source_output_idx = self._decode_wiring(
+                self.circuit.components_count, is_output=True
+            )
+            self.circuit.connect_output(output_idx, source_idx, source_output_idx)
+        return self.circuit
+
+    def _decode_component_circuit(
+        self, idx: int, component_idx: int, was_same: int
+    ) -> int:
+        if component_idx > 0 and self.models.same_circuit.decode(self.coder, was_same):
+            self.components_ids.append(self.components_ids[-1])
+            return 1
+        distance = self.models.circuit_distance.decode(self.coder)
+        if distance >= idx:
+            raise ValueError(
+                f"Circuit {idx}: trying to use the undefined component "
+                f"{idx - 1 - distance}."
+            )
+        self.components_ids.append(idx - 1 - distance)
+        return 0
+
+    def _decode_inputs(self, component_idx: int, inputs_count: int):
+        models = self.models
+        circuit = self.circuit
+        for input_idx in range(inputs_count):
+            context = min(input_idx, MAX_INPUT_CONTEXT)
+            provenance = models.provenance.decode(
+                self.coder, 2 * context + self.provenance
+            )
+            self.provenance = provenance
+            if provenance == 1:
+                source_idx, source_output_idx = self._decode_wiring(
+                    component_idx, is_output=False
+                )
+                circuit.stash_connection(
+                    ConnectionParameters(
+                        source_idx, source_output_idx, component_idx, input_idx
+                    )
+                )
+                continue
+
+            if circuit.inputs_count == 0:
+                raise ValueError(
+                    f"Circuit {circuit.identifier}: the {component_idx}-th component "
+                    f"asked for its {input_idx}-th input an input of the circuit "
+                    f"itself, which does not have any input."
+                )
+            circuit_input_idx = (self.last_input + 1) % circuit.inputs_count
+            if circuit.inputs_count > 1 and not models.next_input.decode(
+                self.coder, context
+            ):
+                circuit_input_idx = models.input_indices[
+                    bitlength_with_offset(circuit.inputs_count)
+                ].decode(self.coder)
+                if circuit_input_idx >= circuit.inputs_count:
+                    raise ValueError(
+                        f"Circuit {circuit.identifier}: the {component_idx}-th "
+                        f"component asked for its {input_idx}-th input the "
+                        f"{circuit_input_idx}-th input of the circuit itself, which "
+                        f"does not exists (there is {circuit.inputs_count} inputs)."
+                    )
+            self.last_input = circuit_input_idx
+            circuit.stash_input(
+                InputParameters(circuit_input_idx, component_idx, input_idx)
+            )
+
+    def _decode_wiring(self, component_idx: int, is_output: bool):
+        models = self.models
+        if models.backward.decode(self.coder, int(is_output)):
+            distance = models.distances[int(is_output)].decode(self.coder)
+            source_idx = component_idx - 1 - distance
+            if source_idx < 0:
+                raise ValueError(
+                    f"Circuit {self.circuit.identifier}: the source of a wire is "
+                    f"before the first component."
+                )
+            outputs_count = self.outputs_counts[self.components_ids[source_idx]]
+        else:
+            source_idx = component_idx + models.forward_distance.decode(self.coder)
+            outputs_count = self.max_outputs
+        if source_idx >= self.circuit.components_count:
+            raise ValueError(
+                f"Circuit {self.circuit.identifier}: the {source_idx}-th component "
+                f"does not exist (there is {self.circuit.components_count} "
+                f"components)."
+            )
+
+        source_output_idx = 0
+        if outputs_count > 1:
+            source_output_idx = models.output_indices[
+                bitlength_with_offset(outputs_count)
+            ].decode(self.coder)
+        return source_idx, source_output_idx
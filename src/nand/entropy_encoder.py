@@ -0,0 +1,225 @@
+from typing import Dict, List, Tuple
+
+from bitarray import bitarray
+
+from nand.bits_utils import bitlength_with_offset
+from nand.circuit import Circuit, CircuitDict, CircuitId, Wire
+from nand.circuit_encoder import CircuitEncoder
+from nand.circuits_library import CircuitLibrary
+from nand.range_coder import (
+    BitModel,
+    BitTreeModels,
+    IntegerModel,
+    RangeEncoder,
+)
+
+# The inputs of a component after the third one share the context of the third one.
+MAX_INPUT_CONTEXT = 3
+
+
+class EntropyModels:
+    """The adaptive models of the fields of 'EntropyEncoder', the same for the
+    decoder. They start from the same state, and are adapted the same way.
+    """
+
+    def __init__(self):
+        self.circuits_count = IntegerModel()
+        self.components_count = IntegerModel()
+        self.inputs_count = IntegerModel()
+        self.outputs_count = IntegerModel()
+
+        # Context: whether the previous component was also the same circuit as its
+        # previous one.
+        self.same_circuit = BitModel(2)
+        self.circuit_distance = IntegerModel()
+
+        # Context: the index of the component input, and the previous provenance.
+        self.provenance = BitModel(2 * (MAX_INPUT_CONTEXT + 1))
+        # Context: the index of the component input.
+        self.next_input = BitModel(MAX_INPUT_CONTEXT + 1)
+        self.input_indices = BitTreeModels()
+
+        # Context: whether the wire is an input of a component, or an output of the
+        # circuit.
+        self.backward = BitModel(2)
+        self.distances = [IntegerModel(), IntegerModel()]
+        self.forward_distance = IntegerModel()
+        self.output_indices = BitTreeModels()
+
+
+class EntropyEncoder(CircuitEncoder):
+    """
+    Encode a circuit library with an adaptive binary range coder.
+
+    The fields are the same as 'BitPackedEncoder', but instead of being bit-packed
+    each one is coded with an adaptive model (see 'nand.range_coder'): the more a
+    value is expected, the fewer bits it costs. In a regular library, most of the
+    fields are predictable from their context:
+    - a component is often the same circuit as the component before it, or a
+      circuit defined just before the current one: the circuit is coded as a flag
+      "same as the previous component", or else as the distance to the current
+      circuit index.
+    - a component input coming from a circuit input is often the input after the
+      one used by the previous component input: it is coded as a flag "next
+      input", or else as the index itself.
+    - a wire coming from a component output is often driven by one of the previous
+      components: the source is coded as the distance to the current component.
+    - when the source component has a single output, its output index isn't coded
+      at all.
+
+    The first field is the number of circuits: the end of the stream can't be
+    deduced from its length anymore.
+
+    Contrary to 'BitPackedEncoder', the stream can only be decoded sequentially: the
+    models at a circuit depend on all the circuits before it.
+    """
+
+    def __init__(self):
+        super().__init__()
+        self.library: CircuitDict = {}
+        self.circuit_indices: Dict[CircuitId, int] = {}
+
+    def encode(self, library: CircuitLibrary) -> bitarray:
+        """
+        library = [circuits_count, circuit_1, circuit_2, ...]
+        """
+        self.library = library.library
+        self.circuit_indices = {
+            identifier: idx for idx, identifier in enumerate(self.library)
+        }
+        self.coder = RangeEncoder()
+        self.models = EntropyModels()
+        # The number of outputs of each circuit already encoded, and their maximum.
+        self.outputs_counts: List[int] = [1]
+        self.max_outputs = 1
+
+        circuits = [c for c in self.library.values() if c.identifier != 0]
+        self.models.circuits_count.encode(self.coder, len(circuits))
+        for idx, circuit in enumerate(circuits, start=1):
+            self._encode_circuit(idx, circuit)
+            self.outputs_counts.append(len(circuit.outputs))
+            self.max_outputs = max(self.max_outputs, len(circuit.outputs))
+
+        encoding = bitarray()
+        encoding.frombytes(self.coder.finish())
+        return encoding
+
+    def _encode_circuit(self, idx: int, circuit: Circuit):
+        """
+        circuit = [header, components, outputs]
+        header = [n_components, n_inputs, n_outputs]
+        """
+        models = self.models
+        models.components_count.encode(self.coder, len(circuit.components))
+        models.inputs_count.encode(self.coder, len(circuit.inputs))
+        models.outputs_count.encode(self.coder, len(circuit.outputs))
+
+        # The lookup tables of the wiring, the first port of a wire taking
+        # precedence, as with 'BitPackedEncoder'.
+        self.inputs_indices: Dict[int, int] = {}
+        for input_idx, wire in enumerate(circuit.inputs.values()):
+            self.inputs_indices.setdefault(wire.id, input_idx)
+        self.drivers: Dict[int, Tuple[int, int]] = {}
+        self.components_ids: List[int] = []
+        for component_idx, component in enumerate(circuit.components.values()):
+            if component.identifier not in self.circuit_indices:
+                raise ValueError(f"Circuit {component.identifier} is not in the library")
+            self.components_ids.append(self.circuit_indices[component.identifier])
+            for output_idx, wire in enumerate(component.outputs.values()):
+                self.drivers.setdefault(wire.id, (component_idx, output_idx))
+
+        self.inputs_count = len(circuit.inputs)
+        self.last_input = -1
+        self.provenance = 0
+        was_same = 0
+        for component_idx, component in enumerate(circuit.components.values()):
+            was_same = self._encode_component_circuit(idx, component_idx, was_same)
+            self._encode_inputs(component, component_idx)
+
+        for output in circuit.outputs.values():
+            self._encode_wiring(output, len(circuit.components), is_output=True)
+
+    def _encode_component_circuit(
+        self, idx: int, component_idx: int, was_same: int
+    ) -> int:
+        """
+        component_circuit = [same_circuit, (distance)]
+
+        Returns:
+            Whether the component is the same circuit as the previous one.
+        """
+        circuit_id = self.components_ids[component_idx]
+        if component_idx > 0:
+            is_same = int(circuit_id == self.components_ids[component_idx - 1])
+            self.models.same_circuit.encode(self.coder, is_same, was_same)
+            if is_same:
+                return 1
+        # The components are defined before the circuit.
+        if circuit_id >= idx:
+            raise ValueError(
+                f"Circuit {idx} uses the circuit {circuit_id}, defined after it."
+            )
+        self.models.circuit_distance.encode(self.coder, idx - 1 - circuit_id)
+        return 0
+
+    def _encode_inputs(self, component: Circuit, component_idx: int):
+        """
+        inputs = [input_0, input_1, ..., input_n]
+        input = [provenance, location]
+        location =
+            if provenance = 0: [next_input, (input index)]
+            if provenance = 1: wiring
+        """
+        models = self.models
+        for input_idx, input in enumerate(component.inputs.values()):
+            context = min(input_idx, MAX_INPUT_CONTEXT)
+            provenance = 0 if input.id in self.inputs_indices else 1
+            models.provenance.encode(
+                self.coder, provenance, 2 * context + self.provenance
+            )
+            self.provenance = provenance
+            if provenance == 1:
+                self._encode_wiring(input, component_idx, is_output=False)
+                continue
+
+            circuit_input_idx = self.inputs_indices[input.id]
+            expected = (self.last_input + 1) % self.inputs_count
+            self.last_input = circuit_input_idx
+            if self.inputs_count == 1:
+                continue
+            is_next = int(circuit_input_idx == expected)
+            models.next_input.encode(self.coder, is_next, context)
+            if not is_next:
+                models.input_indices[bitlength_with_offset(self.inputs_count)].encode(
+                    self.coder, circuit_input_idx
+                )
+
+    def _encode_wiring(self, wire: Wire, component_idx: int, is_output: bool):
+        """
+        wiring = [backward, distance, (output_idx)]
+
+        The source component is coded by its distance to the current component:
+        the component before it is at a distance 0. The output index is only coded
+        if the source component has several outputs.
+        """
+        if wire.id not in self.drivers:
+            raise ValueError(f"Wire {wire.id} not found in any sub_component outputs")
+        source_idx, output_idx = self.drivers[wire.id]
+
+        models = self.models
+        is_backward = int(source_idx < component_idx)
+        models.backward.encode(self.coder, is_backward, int(is_output))
+        if is_backward:
+            models.distances[int(is_output)].encode(
+                self.coder, component_idx - 1 - source_idx
+            )
+            outputs_count = self.outputs_counts[self.components_ids[source_idx]]
+        else:
+            models.forward_distance.encode(self.coder, source_idx - component_idx)
+            # The source isn't known yet by the decoder: any circuit could be it.
+            outputs_count = self.max_outputs
+
+        if outputs_count > 1:
+            models.output_indices[bitlength_with_offset(outputs_count)].encode(
+                self.coder, output_idx
+            )
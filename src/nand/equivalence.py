@@ -0,0 +1,221 @@
+import random
+from dataclasses import dataclass
+from typing import Dict, List, Optional, Tuple
+
+from nand.circuit import Circuit
+from nand.flat_netlist import FlatNetlist, flatten
+from nand.netlist_reducer import ONE, ZERO, ReducedNetlistBuilder, ReductionStats
+from nand.simulator_bit_parallel import SimulatorBitParallel
+
+
+@dataclass
+class EquivalenceResult:
+    """The result of 'equivalent()'.
+
+    Attributes:
+        equivalent: True if the circuits are proven equivalent, False if they differ,
+                    None if the proof was too large to complete.
+        counterexample: If they differ, input values for which an output differs.
+        method: How it was decided: "simulation", "structure", or "bdd".
+    """
+
+    equivalent: Optional[bool]
+    counterexample: Optional[List[bool]] = None
+    method: str = ""
+
+    def __bool__(self):
+        return self.equivalent is True
+
+
+class BddTooLarge(Exception):
+    """Raised when a BDD grows beyond its maximum number of nodes."""
+
+
+class Bdd:
+    """A reduced ordered binary decision diagram manager.
+
+    A node is an index: 0 and 1 are the constants, and any other node tests a
+    variable, the order of the variables being their index. The nodes are unique, so
+    two functions are equal if and only if their nodes are.
+
+    Attributes:
+        max_nodes: The number of nodes after which 'BddTooLarge' is raised.
+    """
+
+    def __init__(self, max_nodes: int):
+        self.max_nodes = max_nodes
+        # The variable, low child, and high child of each node. The constants test a
+        # variable after all the others.
+        self._var: List[int] = [1 << 30, 1 << 30]
+        self._low: List[int] = [0, 1]
+        self._high: List[int] = [0, 1]
+        self._unique: Dict[Tuple[int, int, int], int] = {}
+        self._nands: Dict[Tuple[int, int], int] = {}
+
+    def variable(self, var: int) -> int:
+        return self._node(var, 0, 1)
+
+    def _node(self, var: int, low: int, high: int) -> int:
+        if low == high:
+            return low
+        key = (var, low, high)
+        node = self._unique.get(key)
+        if node is None:
+            if len(self._var) >= self.max_nodes:
+                raise BddTooLarge(f"The BDD exceeds {self.max_nodes} nodes.")
+            node = len(self._var)
+            self._var.append(var)
+            self._low.append(low)
+            self._high.append(high)
+            self._unique[key] = node
+        return node
+
+    def nand(self, f: int, g: int) -> int:
+        if f == 0 or g == 0:
+            return 1
+        if f == 1 and g == 1:
+            return 0
+        if f > g:
+            f, g = g, f
+        key = (f, g)
+        result = self._nands.get(key)
+        if result is not None:
+            return result
+        var = min(self._var[f], self._var[g])
+        f_low, f_high = self._cofactors(f, var)
+        g_low, g_high = self._cofactors(g, var)
+        result = self._node(var, self.nand(f_low, g_low), self.nand(f_high, g_high))
+        self._nands[key] = result
+        return result
+
+    def _cofactors(self, node: int, var: int) -> Tuple[int, int]:
+        if self._var[node] != var:
+            return node, node
+        return self._low[node], self._high[node]
+
+    def xor(self, f: int, g: int) -> int:
+        both = self.nand(f, g)
+        return self.nand(self.nand(f, both), self.nand(g, both))
+
+    def satisfy(self, node: int, variables: int) -> List[bool]:
+        """Values of the variables making a function other than 0 true."""
+        values = [False] * variables
+        while node > 1:
+            if self._low[node] != 0:
+                node = self._low[node]
+            else:
+                values[self._var[node]] = True
+                node = self._high[node]
+        return values
+
+
+def equivalent(
+    circuit_a: Circuit,
+    circuit_b: Circuit,
+    vectors: int = 1 << 12,
+    seed: int = 0,
+    max_nodes: int = 1 << 22,
+) -> EquivalenceResult:
+    """Check if two circuits compute the same outputs for all their inputs.
+
+    The inputs and outputs are matched by position. Three steps, from the cheapest:
+    - random vectors are simulated by the bit-parallel simulator: a different output
+      is a counterexample, found without any proof.
+    - both flat netlists are merged into a "miter", sharing their inputs, with the
+      structural hashing of 'reduce_netlist()': the outputs computed by the same
+      gates are proven equal, e.g. for a circuit and its encoding round trip.
+    - for the remaining outputs, a BDD of each output is built over the merged
+      netlist, in the order of the inputs. Equal outputs have the same BDD, and the
+      BDD of their XOR gives a counterexample otherwise.
+
+    Args:
+        circuit_a: The first circuit. It is not modified.
+        circuit_b: The second circuit. It is not modified.
+        vectors: The number of random vectors simulated first.
+        seed: The seed of the random vectors.
+        max_nodes: The maximum size of the BDD, after which the result is undecided.
+
+    Raises:
+        ValueError: If the circuits don't have the same number of inputs and outputs.
+    """
+    if (len(circuit_a.inputs), len(circuit_a.outputs)) != (
+        len(circuit_b.inputs),
+        len(circuit_b.outputs),
+    ):
+        raise ValueError(
+            f"The circuits {circuit_a.identifier} and {circuit_b.identifier} don't "
+            "have the same numbers of inputs and outputs."
+        )
+    netlist_a = flatten(circuit_a)
+    netlist_b = flatten(circuit_b)
+    n_inputs = len(netlist_a.inputs)
+
+    counterexample = _simulation_counterexample(netlist_a, netlist_b, vectors, seed)
+    if counterexample is not None:
+        return EquivalenceResult(False, counterexample, "simulation")
+
+    builder = ReducedNetlistBuilder(ReductionStats())
+    inputs = builder.add_inputs(n_inputs)
+    outputs_a = builder.add_netlist(netlist_a, inputs)
+    outputs_b = builder.add_netlist(netlist_b, inputs)
+    pairs = [(a, b) for a, b in zip(outputs_a, outputs_b) if a != b]
+    if len(pairs) == 0:
+        return EquivalenceResult(True, None, "structure")
+
+    bdd = Bdd(max_nodes)
+    try:
+        nodes = _bdd_nodes(bdd, builder.netlist, [w for pair in pairs for w in pair])
+        for a, b in pairs:
+            difference = bdd.xor(nodes[a], nodes[b])
+            if difference != 0:
+                return EquivalenceResult(
+                    False, bdd.satisfy(difference, n_inputs), "bdd"
+                )
+    except BddTooLarge:
+        return EquivalenceResult(None, None, "bdd")
+    return EquivalenceResult(True, None, "bdd")
+
+
+def _simulation_counterexample(
+    netlist_a: FlatNetlist, netlist_b: FlatNetlist, vectors: int, seed: int
+) -> Optional[List[bool]]:
+    """Input values found by random simulation, for which the outputs differ."""
+    n_inputs = len(netlist_a.inputs)
+    lanes = SimulatorBitParallel.DEFAULT_LANES
+    simulators = [
+        SimulatorBitParallel(Circuit(""), lanes, netlist)
+        for netlist in (netlist_a, netlist_b)
+    ]
+    rng = random.Random(seed)
+    for start in range(0, vectors, lanes):
+        count = min(lanes, vectors - start)
+        inputs = [rng.getrandbits(count) for _ in range(n_inputs)]
+        outputs_a, outputs_b = [s.simulate_words(inputs, count) for s in simulators]
+        different = 0
+        for word_a, word_b in zip(outputs_a, outputs_b):
+            different |= word_a ^ word_b
+        if different != 0:
+            lane = (different & -different).bit_length() - 1
+            return [(word >> lane) & 1 == 1 for word in inputs]
+    return None
+
+
+def _bdd_nodes(bdd: Bdd, netlist: FlatNetlist, signals: List[int]) -> Dict[int, int]:
+    """The BDD of the given signals of a netlist, the constants included."""
+    needed = [False] * netlist.wires_count
+    for signal in signals:
+        if signal >= 0:
+            needed[signal] = True
+    # The gates are in topological order: the drivers of a gate are before it.
+    for gate in reversed(range(netlist.nands_count)):
+        if needed[netlist.out[gate]]:
+            needed[netlist.in_a[gate]] = True
+            needed[netlist.in_b[gate]] = True
+
+    nodes: Dict[int, int] = {ZERO: 0, ONE: 1}
+    for var, idx in enumerate(netlist.inputs):
+        nodes[idx] = bdd.variable(var)
+    for a, b, out in zip(netlist.in_a, netlist.in_b, netlist.out):
+        if needed[out]:
+            nodes[out] = bdd.nand(nodes[a], nodes[b])
+    return nodes
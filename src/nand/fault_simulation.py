@@ -0,0 +1,178 @@
+from dataclasses import dataclass, field
+from heapq import heapify, heappop, heappush
+from typing import Dict, List, NamedTuple, Optional, Sequence
+
+from nand.circuit import Circuit
+from nand.flat_netlist import FlatNetlist, flatten
+from nand.simulator_bit_parallel import BatchInputs, SimulatorBitParallel, pack_lanes
+
+
+class Fault(NamedTuple):
+    """A wire of a flat netlist stuck at a constant value.
+
+    Attributes:
+        wire: The index of the wire in the netlist.
+        stuck_at: The value of the wire, whatever its driver computes.
+    """
+
+    wire: int
+    stuck_at: bool
+
+    def __str__(self):
+        return f"wire {self.wire} stuck-at-{int(self.stuck_at)}"
+
+
+@dataclass
+class FaultReport:
+    """The result of a fault simulation.
+
+    Attributes:
+        netlist: The simulated netlist, whose wires the faults are on.
+        faults: All the simulated faults.
+        detected: The index of the first vector detecting each detected fault.
+        vectors: The number of simulated vectors.
+    """
+
+    netlist: FlatNetlist
+    faults: List[Fault]
+    detected: Dict[Fault, int] = field(default_factory=dict)
+    vectors: int = 0
+
+    @property
+    def undetected(self) -> List[Fault]:
+        """The faults no vector detects, in order."""
+        return [fault for fault in self.faults if fault not in self.detected]
+
+    @property
+    def coverage(self) -> float:
+        """The ratio of detected faults, 1 without any fault."""
+        if len(self.faults) == 0:
+            return 1.0
+        return len(self.detected) / len(self.faults)
+
+    def __str__(self):
+        return (
+            f"{len(self.detected)}/{len(self.faults)} faults detected "
+            f"({self.coverage:.1%}) by {self.vectors} vectors"
+        )
+
+
+def all_faults(netlist: FlatNetlist) -> List[Fault]:
+    """The stuck-at-0 and stuck-at-1 faults of every wire of a netlist."""
+    return [
+        Fault(wire, stuck_at)
+        for wire in range(netlist.wires_count)
+        for stuck_at in (False, True)
+    ]
+
+
+def simulate_faults(
+    circuit: Circuit,
+    vectors: BatchInputs,
+    faults: Optional[Sequence[Fault]] = None,
+    lanes: int = SimulatorBitParallel.DEFAULT_LANES,
+    netlist: Optional[FlatNetlist] = None,
+) -> FaultReport:
+    """Grade a set of vectors against the stuck-at faults of a circuit.
+
+    A fault is detected by a vector if an output of the faulty circuit differs from
+    the one of the correct circuit. The vectors are simulated by chunks of 'lanes'
+    vectors, with the bit-parallel simulator for the correct circuit. Then, each fault
+    not detected yet is injected alone, and propagated for all the vectors of the
+    chunk at once: only through the gates whose inputs differ from the correct
+    circuit, in topological order. A detected fault is dropped: it isn't simulated
+    for the next chunks.
+
+    The faults are on the wires of the flat netlist: the inputs of the circuit and the
+    outputs of the NAND gates. A wire read by several gates is faulty for all of them.
+
+    Args:
+        circuit: The circuit to grade. It is not modified.
+        vectors: The input vectors, one row per vector.
+        faults: The faults to simulate, all the ones of the netlist by default (see
+        'all_faults()').
+        lanes: The number of vectors simulated at once.
+        netlist: The flat netlist of the circuit, if already flattened.
+
+    Returns:
+        The detected and undetected faults.
+    """
+    if netlist is None:
+        netlist = flatten(circuit)
+    simulator = SimulatorBitParallel(Circuit(circuit.identifier), lanes, netlist)
+    faults = all_faults(netlist) if faults is None else list(faults)
+    report = FaultReport(netlist, faults)
+    propagation = _FaultPropagation(netlist)
+
+    remaining = report.faults
+    for start in range(0, len(vectors), lanes):
+        chunk = vectors[start : start + lanes]
+        simulator.simulate_words(pack_lanes(chunk), len(chunk))
+        propagation.good = simulator.words
+        mask = (1 << len(chunk)) - 1
+        undetected: List[Fault] = []
+        for fault in remaining:
+            detecting = propagation.detecting_lanes(fault, mask)
+            if detecting == 0:
+                undetected.append(fault)
+            else:
+                # The lowest lane is the first vector of the chunk detecting it.
+                first = (detecting & -detecting).bit_length() - 1
+                report.detected[fault] = start + first
+        remaining = undetected
+        if len(remaining) == 0:
+            break
+    report.vectors = len(vectors)
+    return report
+
+
+class _FaultPropagation:
+    """Propagate single faults from the words of the correct circuit.
+
+    Attributes:
+        good: The word of each wire in the correct circuit.
+        readers: The gates reading each wire.
+        outputs: The wires of the outputs of the circuit.
+    """
+
+    def __init__(self, netlist: FlatNetlist):
+        self._netlist = netlist
+        self.good: List[int] = []
+        self.readers: List[List[int]] = [[] for _ in range(netlist.wires_count)]
+        for gate, (a, b) in enumerate(zip(netlist.in_a, netlist.in_b)):
+            self.readers[a].append(gate)
+            if b != a:
+                self.readers[b].append(gate)
+        self.outputs = set(netlist.outputs)
+
+    def detecting_lanes(self, fault: Fault, mask: int) -> int:
+        """The lanes where the fault changes an output of the circuit."""
+        good = self.good
+        forced = mask if fault.stuck_at else 0
+        if forced == good[fault.wire]:
+            return 0
+        # The words of the wires differing from the correct circuit.
+        faulty: Dict[int, int] = {fault.wire: forced}
+        in_a, in_b, out = self._netlist.in_a, self._netlist.in_b, self._netlist.out
+        # The gates are in topological order: the lowest gate first is an order
+        # where each gate is evaluated after all its changed inputs.
+        pending = list(self.readers[fault.wire])
+        heapify(pending)
+        scheduled = set(pending)
+        while len(pending) != 0:
+            gate = heappop(pending)
+            out_wire = out[gate]
+            a, b = in_a[gate], in_b[gate]
+            word = mask ^ (faulty.get(a, good[a]) & faulty.get(b, good[b]))
+            if word == good[out_wire]:
+                continue
+            faulty[out_wire] = word
+            for reader in self.readers[out_wire]:
+                if reader not in scheduled:
+                    scheduled.add(reader)
+                    heappush(pending, reader)
+
+        detecting = 0
+        for wire in self.outputs.intersection(faulty):
+            detecting |= faulty[wire] ^ good[wire]
+        return detecting
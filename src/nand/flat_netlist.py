@@ -0,0 +1,178 @@
+from array import array
+from typing import Dict, List
+
+from nand.circuit import Circuit
+from nand.circuit_definition import CircuitDefinition, definition_from_circuit
+
+
+class FlatNetlist:
+    """A circuit lowered to a flat array of NAND gates.
+
+    The hierarchy of components is gone: only the NAND gates are left, in an order
+    where each gate only depends on the circuit inputs or on the gates before it.
+    The wires are replaced by dense indices into a single state buffer.
+
+    The gates are stored as a "structure of arrays": the i-th gate reads the wires
+    'in_a[i]' and 'in_b[i]', and writes the wire 'out[i]'.
+
+    Attributes:
+        wires_count: The number of wires, i.e. the size of the state buffer.
+        inputs: The wire index of each input of the circuit, in order.
+        outputs: The wire index of each output of the circuit, in order.
+        in_a: The wire index of the first input of each NAND gate.
+        in_b: The wire index of the second input of each NAND gate.
+        out: The wire index of the output of each NAND gate.
+        levels: If the netlist was levelized, the index of the first gate of each
+                topological level, and the number of gates as a last element.
+                Otherwise, empty.
+    """
+
+    def __init__(self):
+        self.wires_count = 0
+        self.inputs: List[int] = []
+        self.outputs: List[int] = []
+        self.in_a = array("l")
+        self.in_b = array("l")
+        self.out = array("l")
+        self.levels: List[int] = []
+
+    def add_wire(self) -> int:
+        """Allocate a new wire in the state buffer and return its index."""
+        self.wires_count += 1
+        return self.wires_count - 1
+
+    def add_nand(self, a: int, b: int) -> int:
+        """Add a NAND gate reading the wires 'a' and 'b', and return the index of its
+        output wire.
+        """
+        out = self.add_wire()
+        self.in_a.append(a)
+        self.in_b.append(b)
+        self.out.append(out)
+        return out
+
+    @property
+    def nands_count(self) -> int:
+        return len(self.out)
+
+    def __repr__(self):
+        return (
+            f"FlatNetlist(wires_count={self.wires_count}, inputs={self.inputs}, "
+            f"outputs={self.outputs}, nands={list(zip(self.in_a, self.in_b, self.out))})"
+        )
+
+
+def flatten(circuit: Circuit) -> FlatNetlist:
+    """Lower a circuit into a flat netlist of NAND gates.
+
+    The circuit is converted into shared definitions, each one in topological order,
+    and flattened through them (see 'flatten_definition()'). The circuit isn't
+    modified.
+
+    Args:
+        circuit: The circuit to flatten.
+
+    Returns:
+        The flat netlist of the circuit.
+
+    Raises:
+        ValueError: If a wire is read before being driven, meaning the circuit has a
+        missing connection.
+    """
+    return flatten_definition(definition_from_circuit(circuit))
+
+
+def flatten_definition(definition: CircuitDefinition) -> FlatNetlist:
+    """Lower a circuit definition into a flat netlist of NAND gates.
+
+    A single depth-first walk of the components emits the NAND gates in an order that
+    can be simulated in one pass. Each instance only maps the slots of its definition
+    to the wires of the netlist.
+
+    Args:
+        definition: The definition to flatten.
+
+    Returns:
+        The flat netlist of the definition.
+    """
+    netlist = FlatNetlist()
+    netlist.inputs = [netlist.add_wire() for _ in definition.inputs]
+    netlist.outputs = _flatten_instance(definition, netlist.inputs, netlist)
+    return netlist
+
+
+def _flatten_instance(
+    definition: CircuitDefinition, inputs: List[int], netlist: FlatNetlist
+) -> List[int]:
+    """Recursively emit the NAND gates of an instance into the netlist.
+
+    Args:
+        definition: The definition of the instance.
+        inputs: The wire index of each input of the instance.
+
+    Returns:
+        The wire index of each output of the instance.
+    """
+    # Base case: the component is a NAND gate.
+    if definition.is_nand:
+        return [netlist.add_nand(inputs[0], inputs[1])]
+
+    # The wire index of each slot of the definition.
+    wires = inputs + [0] * (definition.slots_count - len(inputs))
+    for component in definition.components:
+        outputs = _flatten_instance(
+            component.definition, [wires[slot] for slot in component.inputs], netlist
+        )
+        base = component.outputs_base
+        wires[base : base + len(outputs)] = outputs
+    return [wires[slot] for slot in definition.output_slots]
+
+
+def levelize(netlist: FlatNetlist) -> FlatNetlist:
+    """Reorder a netlist by topological level, and renumber its wires to match.
+
+    The level of a gate is the length of the longest path from the circuit inputs to
+    it. All the gates of a level are independent from each other, and their order is
+    kept from the original netlist.
+
+    The wires are renumbered in the order they are written: first the inputs, then
+    the outputs of the gates, level by level. So, the outputs of a level are
+    contiguous in the state buffer, and a level reads a few contiguous regions
+    written by the previous levels instead of wires scattered across the whole buffer.
+
+    Args:
+        netlist: The netlist to levelize, in topological order.
+
+    Returns:
+        A new levelized netlist, with the same inputs and outputs.
+    """
+    wire_levels = [0] * netlist.wires_count
+    gate_levels: List[int] = []
+    for a, b, out in zip(netlist.in_a, netlist.in_b, netlist.out):
+        level = max(wire_levels[a], wire_levels[b]) + 1
+        wire_levels[out] = level
+        gate_levels.append(level)
+
+    # A stable sort keeps the original order inside a level.
+    order = sorted(range(netlist.nands_count), key=gate_levels.__getitem__)
+
+    levelized = FlatNetlist()
+    indices: Dict[int, int] = {}
+    for idx in netlist.inputs:
+        indices[idx] = levelized.add_wire()
+        levelized.inputs.append(indices[idx])
+
+    current_level = 0
+    for gate_idx, gate in enumerate(order):
+        if gate_levels[gate] != current_level:
+            current_level = gate_levels[gate]
+            levelized.levels.append(gate_idx)
+        out = levelized.add_nand(
+            indices[netlist.in_a[gate]], indices[netlist.in_b[gate]]
+        )
+        indices[netlist.out[gate]] = out
+    levelized.levels.append(levelized.nands_count)
+
+    levelized.outputs = [indices[idx] for idx in netlist.outputs]
+
+    return levelized
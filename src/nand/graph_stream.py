@@ -0,0 +1,249 @@
+import subprocess
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Dict, Iterator, Optional, TextIO, Tuple
+
+from nand.circuit import Circuit, CircuitId
+
+
+@dataclass
+class DotOptions:
+    """Options of the streamed DOT export.
+
+    Attributes:
+        max_depth: The depth from which the components are collapsed into a single
+                   box, the components of the circuit being at depth 0. -1 to expand
+                   everything down to the NAND gates.
+        max_gates: The number of NAND gates above which a component is collapsed,
+                   whatever its depth. None to never collapse on size.
+        clusters: Draw each expanded component as a cluster around its content.
+        is_aligned: Align the inputs of the circuit on the left, and its outputs on
+                    the right.
+        bold_io: Draw the wires of the inputs and outputs of the circuit in bold.
+    """
+
+    max_depth: int = -1
+    max_gates: Optional[int] = None
+    clusters: bool = True
+    is_aligned: bool = True
+    bold_io: bool = True
+
+
+# The walk of a circuit: the expanded components are opened and closed around their
+# content, and the drawn components are leaves.
+type WalkEvent = Tuple[str, Circuit]
+
+
+class DotWriter:
+    """Write the graph of a circuit as DOT text, while walking it.
+
+    Nothing but the text is built: the whole graph is never in memory, only the node
+    driving each wire. Two walks of the circuit are done, with the same nodes in the
+    same order: the first one writes the nodes, inside their clusters, and finds the
+    driver of each wire; the second one writes the edges, at the top level of the
+    graph so that they don't move their nodes into a cluster.
+
+    The NAND gates and the collapsed components are the nodes: a collapsed component
+    is a box labelled with its name (see 'DotOptions' for the level of detail). A
+    wire driven by nothing, i.e. a missing connection, isn't drawn.
+    """
+
+    def __init__(self, circuit: Circuit, options: Optional[DotOptions] = None):
+        self.circuit = circuit
+        self.options = options if options is not None else DotOptions()
+        # The number of NAND gates of each circuit, by identifier.
+        self._gates_counts: Dict[CircuitId, int] = {0: 1}
+        # The node driving each wire, by the identifier of the wire.
+        self._drivers: Dict[int, str] = {}
+        self._colors: Dict[CircuitId, str] = {}
+        self.nodes_count = 0
+        self.edges_count = 0
+
+    def write(self, file: TextIO):
+        """Write the graph into a text file."""
+        circuit = self.circuit
+        file.write(f"digraph {_quote(f'Circuit_{circuit.identifier}')} {{\n")
+        file.write(f"  rankdir=LR;\n  label={_quote(circuit.name)};\n")
+        file.write("  node [style=filled];\n")
+
+        for name, wire in circuit.inputs.items():
+            self._write_port(file, f"in_{name}", circuit.inputs_names[name], "#aaffaa")
+            self._drivers[wire.id] = f"in_{name}"
+        for name in circuit.outputs:
+            self._write_port(
+                file, f"out_{name}", circuit.outputs_names[name], "#ffaaaa"
+            )
+        if self.options.is_aligned:
+            inputs = " ".join(_quote(f"in_{name}") for name in circuit.inputs)
+            outputs = " ".join(_quote(f"out_{name}") for name in circuit.outputs)
+            file.write(f"  {{ rank=min; {inputs} }}\n  {{ rank=max; {outputs} }}\n")
+
+        self._write_nodes(file)
+        self._write_edges(file)
+        file.write("}\n")
+
+    def _write_port(self, file: TextIO, node: str, label: str, color: str):
+        file.write(
+            f"  {_quote(node)} [label={_quote(label)}, shape=circle, "
+            f'fillcolor="{color}"];\n'
+        )
+
+    def _write_nodes(self, file: TextIO):
+        indent = "  "
+        clusters = 0
+        node = 0
+        for event, component in self._walk(self.circuit, 0):
+            if event == "open":
+                clusters += 1
+                file.write(
+                    f"{indent}subgraph cluster_{clusters} {{\n"
+                    f"{indent}  label={_quote(component.name)}; "
+                    'style="rounded,filled"; fillcolor="#f0f0f0";\n'
+                )
+                indent += "  "
+            elif event == "close":
+                indent = indent[:-2]
+                file.write(f"{indent}}}\n")
+            else:
+                key = f"n{node}"
+                node += 1
+                if component.identifier == 0:
+                    file.write(
+                        f'{indent}{_quote(key)} [label="NAND", shape=box, '
+                        'fillcolor="#ccccff"];\n'
+                    )
+                else:
+                    color = self._color(component.identifier)
+                    file.write(
+                        f"{indent}{_quote(key)} [label={_quote(component.name)}, "
+                        f'shape=component, fillcolor="{color}"];\n'
+                    )
+                for wire in component.outputs.values():
+                    self._drivers[wire.id] = key
+        self.nodes_count = node
+
+    def _write_edges(self, file: TextIO):
+        bold = " [penwidth=2]" if self.options.bold_io else ""
+        edges = 0
+        node = 0
+        for event, component in self._walk(self.circuit, 0):
+            if event != "leaf":
+                continue
+            key = f"n{node}"
+            node += 1
+            # A component reading a wire several times is connected once.
+            wire_ids = dict.fromkeys(wire.id for wire in component.inputs.values())
+            for wire_id in wire_ids:
+                driver = self._drivers.get(wire_id)
+                if driver is not None:
+                    style = bold if driver.startswith("in_") else ""
+                    file.write(f"  {_quote(driver)} -> {_quote(key)}{style};\n")
+                    edges += 1
+        for name, wire in self.circuit.outputs.items():
+            driver = self._drivers.get(wire.id)
+            if driver is not None:
+                output = _quote(f"out_{name}")
+                file.write(f"  {_quote(driver)} -> {output}{bold};\n")
+                edges += 1
+        self.edges_count = edges
+
+    def _walk(self, circuit: Circuit, depth: int) -> Iterator[WalkEvent]:
+        """Walk the components of a circuit, expanded or drawn as leaves."""
+        for component in circuit.components.values():
+            if component.identifier == 0 or self._is_collapsed(component, depth):
+                yield "leaf", component
+                continue
+            if self.options.clusters:
+                yield "open", component
+            yield from self._walk(component, depth + 1)
+            if self.options.clusters:
+                yield "close", component
+
+    def _is_collapsed(self, component: Circuit, depth: int) -> bool:
+        options = self.options
+        if options.max_depth >= 0 and depth >= options.max_depth:
+            return True
+        return (
+            options.max_gates is not None
+            and self._gates_count(component) > options.max_gates
+        )
+
+    def _gates_count(self, circuit: Circuit) -> int:
+        """The number of NAND gates of a circuit, computed once per identifier."""
+        count = self._gates_counts.get(circuit.identifier)
+        if count is None:
+            count = sum(self._gates_count(c) for c in circuit.components.values())
+            self._gates_counts[circuit.identifier] = count
+        return count
+
+    def _color(self, identifier: CircuitId) -> str:
+        """A light color per circuit, the hues spread by the golden ratio."""
+        color = self._colors.get(identifier)
+        if color is None:
+            hue = (len(self._colors) * (5**0.5 - 1) / 2) % 1
+            color = f"{hue:.3f} 0.35 1.000"
+            self._colors[identifier] = color
+        return color
+
+
+def _quote(text: str) -> str:
+    escaped = str(text).replace("\\", "\\\\").replace('"', '\\"')
+    return f'"{escaped}"'
+
+
+def write_dot(
+    circuit: Circuit, file: TextIO, options: Optional[DotOptions] = None
+) -> DotWriter:
+    """Stream the graph of a circuit as DOT text into a file (see 'DotWriter')."""
+    writer = DotWriter(circuit, options)
+    writer.write(file)
+    return writer
+
+
+def save_dot_graph(
+    circuit: Circuit,
+    filename: str,
+    format: str,
+    options: Optional[DotOptions] = None,
+) -> str:
+    """Save the graph of a circuit, rendered by Graphviz unless the format is "dot".
+
+    The DOT text is streamed into the standard input of Graphviz' dot, which must be
+    available in $PATH: nothing but the walk of the circuit is kept in memory.
+
+    Returns:
+        The name of the saved file.
+    """
+    output_file = f"{filename}.{format}"
+    if format == "dot":
+        with open(output_file, "w") as file:
+            write_dot(circuit, file, options)
+        return output_file
+
+    process = subprocess.Popen(
+        ["dot", f"-T{format}", "-o", output_file],
+        stdin=subprocess.PIPE,
+        text=True,
+    )
+    assert process.stdin is not None
+    try:
+        write_dot(circuit, process.stdin, options)
+    finally:
+        process.stdin.close()
+    if process.wait() != 0:
+        raise RuntimeError(f"Graphviz failed to render {output_file}.")
+    return output_file
+
+
+# Example usage
+if __name__ == "__main__":
+    from nand.circuit_generators import array_multiplier
+
+    # A 16x16 multiplier, with its adders collapsed into boxes.
+    circuit = array_multiplier(16)
+    for name, options in (
+        ("multiplier_16_gates", DotOptions(clusters=False)),
+        ("multiplier_16_adders", DotOptions(max_depth=1)),
+    ):
+        path = Path(save_dot_graph(circuit, name, "dot", options))
+        print(f"Graph saved to {path} ({path.stat().st_size} bytes)")
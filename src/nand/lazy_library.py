@@ -0,0 +1,253 @@
+import mmap
+import struct
+from pathlib import Path
+from typing import Dict, List, Optional, OrderedDict, Sequence, Tuple
+
+from bitarray import bitarray
+
+from nand.bit_packed_decoder import BitPackedDecoder
+from nand.bit_packed_encoder import BitPackedEncoder
+from nand.bits_utils import BitReader
+from nand.circuit import Circuit, CircuitDict, CircuitId
+from nand.circuits_library import CircuitLibrary
+from nand.decoded_circuit import DecodedCircuit
+from nand.disk_cache import write_atomically
+
+# The index section: a magic, the length of the stream in bits, the number of
+# circuits, and the bit offset of each circuit. All little-endian 64 bits integers.
+INDEX_MAGIC = b"NANDIDX1"
+INDEX_SUFFIX = ".idx"
+
+
+class BitPackedIndex:
+    """The random-access index of a bit-packed stream.
+
+    Attributes:
+        bits_count: The length of the stream, in bits. A stream saved to a file is
+                    padded to whole bytes, this is the length without the padding.
+        offsets: The bit offset of each encoded circuit, the i-th one being the
+                 circuit of index i + 1 (the NAND gate isn't encoded).
+    """
+
+    def __init__(self, bits_count: int, offsets: Sequence[int]):
+        self.bits_count = bits_count
+        self.offsets = list(offsets)
+
+    @classmethod
+    def from_encoder(cls, encoder: BitPackedEncoder, data: bitarray) -> "BitPackedIndex":
+        """Get the index of the stream the encoder just encoded."""
+        return cls(len(data), encoder.circuit_offsets)
+
+    def to_bytes(self) -> bytes:
+        return INDEX_MAGIC + struct.pack(
+            f"<QQ{len(self.offsets)}Q", self.bits_count, len(self.offsets), *self.offsets
+        )
+
+    @classmethod
+    def from_bytes(cls, data: bytes) -> "BitPackedIndex":
+        header_size = len(INDEX_MAGIC) + 16
+        if data[: len(INDEX_MAGIC)] != INDEX_MAGIC or len(data) < header_size:
+            raise ValueError("The data is not a bit-packed index.")
+        bits_count, count = struct.unpack_from("<QQ", data, len(INDEX_MAGIC))
+        if len(data) != header_size + 8 * count:
+            raise ValueError(f"The index should have {count} offsets.")
+        return cls(bits_count, struct.unpack_from(f"<{count}Q", data, header_size))
+
+
+def encode_with_index(library: CircuitLibrary) -> tuple[bitarray, BitPackedIndex]:
+    """Encode a library with 'BitPackedEncoder', and get the index of the stream."""
+    encoder = BitPackedEncoder()
+    data = encoder.encode(library)
+    return data, BitPackedIndex.from_encoder(encoder, data)
+
+
+class LazyCircuitLibrary(CircuitLibrary):
+    """A library of bit-packed circuits, decoded on demand.
+
+    With the index of the stream, a circuit can be decoded without the ones before
+    it: only the circuit and its transitive dependencies are decoded, the first time
+    they are asked for. The decoded circuits are then kept.
+
+    As with 'BitPackedDecoder', the identifier of a circuit is its index. Until
+    'decode_all()' is called, 'library' only has the circuits already decoded.
+
+    A library opened by 'open_library()' maps its file until 'close()' is called, or
+    the end of its 'with' block.
+    """
+
+    def __init__(
+        self,
+        data: bitarray,
+        index: BitPackedIndex,
+        mapping: Optional[mmap.mmap] = None,
+    ):
+        """
+        Args:
+            data: The bit-packed stream.
+            index: The index of the stream.
+            mapping: The mapped file the stream is read from, closed by 'close()'.
+        """
+        super().__init__()
+        self._data = data
+        self._index = index
+        self._mapping = mapping
+        self._scanner: Optional[_ComponentsScanner] = _ComponentsScanner(data, index)
+        self.library[0] = BitPackedDecoder()._build_nand()
+
+    def __len__(self) -> int:
+        return len(self._index.offsets) + 1
+
+    @property
+    def decoded_count(self) -> int:
+        """The number of circuits already decoded, the NAND gate included."""
+        return len(self.library)
+
+    def has_circuit(self, identifier: CircuitId) -> bool:
+        return isinstance(identifier, int) and 0 <= identifier < len(self)
+
+    def add_circuit(self, circuit: Circuit):
+        if circuit.identifier in self.library:
+            raise ValueError(f"Circuit {circuit.identifier} already exists")
+        self.library[circuit.identifier] = circuit
+
+    def get_circuit(self, identifier: CircuitId) -> Circuit:
+        if self.has_circuit(identifier) and identifier not in self.library:
+            self._decode(identifier)  # type: ignore[arg-type]
+        return super().get_circuit(identifier)
+
+    def get_all_circuits(self) -> CircuitDict:
+        self.decode_all()
+        return super().get_all_circuits()
+
+    def decode_all(self):
+        """Decode all the remaining circuits, e.g. to encode the library again: once
+        done, 'library' has all the circuits, in the order of the stream."""
+        for idx in range(len(self)):
+            if idx not in self.library:
+                self._decode(idx)
+        self.library = OrderedDict(sorted(self.library.items()))
+
+    def get_circuit_from_idx(self, idx: int) -> Circuit:
+        if not self.has_circuit(idx):
+            raise ValueError(f"Circuit of index {idx} does not exist")
+        return self.get_circuit(idx)
+
+    def close(self):
+        """Unmap the file of the stream. The circuits already decoded stay valid, the
+        other ones can't be decoded anymore."""
+        # The readers of the stream share the buffer of the mapping: they're released
+        # first, the mapping can't be closed while its buffer is exported.
+        self._data = bitarray()
+        self._scanner = None
+        if self._mapping is not None:
+            self._mapping.close()
+            self._mapping = None
+
+    def __enter__(self) -> "LazyCircuitLibrary":
+        return self
+
+    def __exit__(self, *exc_info):
+        self.close()
+
+    def _decode(self, idx: int):
+        """Decode a circuit into the library, after its missing dependencies.
+
+        The dependencies are walked with a stack rather than by recursion, so that a
+        long chain of circuits, each one using the previous one, can be decoded: a
+        circuit is only decoded once all its components are in the library.
+        """
+        if self._scanner is None:
+            raise ValueError(f"Can't decode the circuit {idx}: the library is closed.")
+        scanner = self._scanner
+        # The circuits to decode, and whether their components are already decoded.
+        stack: List[Tuple[int, bool]] = [(idx, False)]
+        while stack:
+            current, is_ready = stack.pop()
+            if current in self.library:
+                continue
+            if is_ready:
+                BitPackedDecoder(self).decode_circuit_at(
+                    self._data, self._index.offsets[current - 1], current
+                )
+                continue
+            stack.append((current, True))
+            for component_id in scanner.components_ids(current):
+                if component_id not in self.library:
+                    stack.append((component_id, False))
+
+
+class _ComponentsScanner(BitPackedDecoder):
+    """Read the identifiers of the components of a circuit, without decoding it nor
+    its components: only their numbers of inputs are needed, read from the header of
+    their own encoding."""
+
+    def __init__(self, data: bitarray, index: BitPackedIndex):
+        super().__init__()
+        self._index = index
+        self._inputs_counts: Dict[int, int] = {0: 2}
+        self.data = BitReader(data)
+        if index.offsets:
+            self._decode_global_header()
+
+    def components_ids(self, idx: int) -> List[int]:
+        self.data.position = self._index.offsets[idx - 1]
+        self.circuit = DecodedCircuit(idx)
+        self._decode_circuit_header()
+        components_ids = []
+        for component_idx in range(self.circuit.components_count):
+            circuit_id = self.data.read(self.circuits_bitlength)
+            # As with a full decoding, a circuit can only use the circuits before it.
+            if circuit_id >= idx:
+                raise ValueError(f"Trying to use the undefined component {circuit_id}.")
+            components_ids.append(circuit_id)
+            inputs_count = self._inputs_count(circuit_id)
+            self._decode_component_inputs(component_idx, inputs_count)
+        return components_ids
+
+    def _inputs_count(self, idx: int) -> int:
+        if idx not in self._inputs_counts:
+            position = self.data.position
+            self.data.position = (
+                self._index.offsets[idx - 1] + self.max_components_bitlength
+            )
+            self._inputs_counts[idx] = self.data.read_with_offset(
+                self.max_inputs_bitlength
+            )
+            self.data.position = position
+        return self._inputs_counts[idx]
+
+
+def save_library(library: CircuitLibrary, path: Path | str):
+    """Save a library bit-packed, with its index next to it ('<path>.idx')."""
+    path = Path(path)
+    data, index = encode_with_index(library)
+    write_atomically(path, data.tobytes())
+    write_atomically(_index_path(path), index.to_bytes())
+
+
+def open_library(path: Path | str) -> LazyCircuitLibrary:
+    """Open a library saved by 'save_library()'.
+
+    The file is memory-mapped: opening it doesn't read it, and only the pages of the
+    circuits actually decoded are loaded. The mapping is kept until the library is
+    closed:
+
+        with open_library(path) as library:
+            circuit = library.get_circuit(idx)
+    """
+    path = Path(path)
+    index = BitPackedIndex.from_bytes(_index_path(path).read_bytes())
+    with open(path, "rb") as file:
+        if index.bits_count == 0:
+            return LazyCircuitLibrary(bitarray(), index)
+        mapped = mmap.mmap(file.fileno(), 0, access=mmap.ACCESS_READ)
+    if len(mapped) != (index.bits_count + 7) // 8:
+        mapped.close()
+        raise ValueError(f"The index of {path} doesn't match the library.")
+    # The padding of the last byte is kept: the circuits are read from their offset,
+    # the end of the stream is never looked for.
+    return LazyCircuitLibrary(bitarray(buffer=mapped), index, mapped)
+
+
+def _index_path(path: Path) -> Path:
+    return path.with_name(path.name + INDEX_SUFFIX)
@@ -0,0 +1,335 @@
+from concurrent.futures import ProcessPoolExecutor
+from dataclasses import dataclass
+from itertools import permutations
+from typing import Dict, List, Optional, Sequence, Tuple
+
+from nand.circuit import Circuit, CircuitId, InputId
+from nand.circuit_generators import nand_network
+from nand.circuits_library import CircuitLibrary
+
+# The inputs of the circuits found are limited by the size of the truth tables, and
+# by the time of the search.
+MAX_INPUTS = 5
+
+type Gate = Tuple[int, int]
+
+
+def input_tables(inputs_count: int) -> List[int]:
+    """The truth table of each input: the bit 'v' of the i-th one is the i-th bit of
+    'v', as for the vectors of 'exhaustive_truth_table()'."""
+    size = 1 << inputs_count
+    return [
+        sum(1 << v for v in range(size) if (v >> i) & 1) for i in range(inputs_count)
+    ]
+
+
+@dataclass
+class NandNetwork:
+    """A single output circuit of NAND gates.
+
+    The signals are numbered: first the inputs, then the output of each gate.
+
+    Attributes:
+        inputs_count: The number of inputs.
+        gates: The two signals read by each gate, in topological order.
+        output: The signal of the output.
+    """
+
+    inputs_count: int
+    gates: List[Gate]
+    output: int
+
+    def truth_table(self) -> int:
+        tables = input_tables(self.inputs_count)
+        mask = (1 << (1 << self.inputs_count)) - 1
+        for a, b in self.gates:
+            tables.append(mask ^ (tables[a] & tables[b]))
+        return tables[self.output]
+
+    def permuted(self, permutation: Sequence[int]) -> "NandNetwork":
+        """The network computing 'permute_table(table, inputs_count, permutation)',
+        for the truth table of this one."""
+        k = self.inputs_count
+        # The i-th input of this network becomes the input whose new index is i.
+        inverse = [0] * k
+        for i, p in enumerate(permutation):
+            inverse[p] = i
+
+        def signal(s: int) -> int:
+            return inverse[s] if s < k else s
+
+        gates = [(signal(a), signal(b)) for a, b in self.gates]
+        return NandNetwork(k, gates, signal(self.output))
+
+    def to_circuit(
+        self,
+        identifier: CircuitId,
+        inputs: Optional[Sequence[InputId]] = None,
+        library: Optional[CircuitLibrary] = None,
+    ) -> Circuit:
+        """Build the network as a circuit, ready to be added to a library.
+
+        Args:
+            identifier: The identifier of the circuit.
+            inputs: The identifiers of the inputs, 'A', 'B', ... by default.
+            library: The library the NAND gate comes from.
+        """
+        if inputs is None:
+            inputs = [chr(ord("A") + i) for i in range(self.inputs_count)]
+        return nand_network(identifier, inputs, self.gates, self.output, library)
+
+
+def permute_table(table: int, inputs_count: int, permutation: Sequence[int]) -> int:
+    """The truth table of a function whose i-th input is the 'permutation[i]'-th
+    input of the given one."""
+    permuted = 0
+    for v in range(1 << inputs_count):
+        if (table >> v) & 1:
+            w = 0
+            for i in range(inputs_count):
+                if (v >> permutation[i]) & 1:
+                    w |= 1 << i
+            permuted |= 1 << w
+    return permuted
+
+
+def canonical_table(table: int, inputs_count: int) -> Tuple[int, Tuple[int, ...]]:
+    """The smallest truth table among the permutations of the inputs of a function.
+
+    Returns:
+        The canonical table, and the permutation 'p' such that
+        'permute_table(canonical, inputs_count, p) == table'.
+    """
+    best: Optional[Tuple[int, Tuple[int, ...]]] = None
+    for permutation in permutations(range(inputs_count)):
+        permuted = permute_table(table, inputs_count, permutation)
+        if best is None or permuted < best[0]:
+            best = (permuted, permutation)
+    assert best is not None
+    canonical, permutation = best
+    inverse = [0] * inputs_count
+    for i, p in enumerate(permutation):
+        inverse[p] = i
+    return canonical, tuple(inverse)
+
+
+class _Search:
+    """A depth-first search of the networks of a given number of gates computing a
+    target truth table.
+
+    Each network is enumerated once, up to the order of its independent gates:
+    - a gate computing an already available function is useless: the function can be
+      read instead. So, all the functions of a network are different.
+    - two consecutive gates, the second one not reading the first one, could be
+      swapped: only the order where the first one has the smallest truth table is
+      enumerated. The output, read by no gate, is always the last one.
+    - at the end, all the gates but the output, and all the inputs the target
+      depends on, must be read. As a gate reads at most two unread signals, a
+      network with too many unread signals for its remaining gates is dropped.
+
+    The state of the network being built is updated in place, gate after gate.
+    """
+
+    def __init__(self, target: int, inputs_count: int, gates_count: int):
+        self.target = target
+        self.inputs_count = inputs_count
+        self.gates_count = gates_count
+        self.mask = (1 << (1 << inputs_count)) - 1
+        self.input_tables = input_tables(inputs_count)
+        self.essential = [
+            _swap_cofactors(target, table) != target for table in self.input_tables
+        ]
+
+    def _reset(self, prefix: List[Gate]):
+        """Set the state to the network of the prefix."""
+        self.tables = list(self.input_tables)
+        self.existing = set(self.tables)
+        self.gates: List[Gate] = []
+        # The number of reads of each signal, and the number of signals still to be
+        # read: the essential inputs, and the gates.
+        self.reads = [0] * self.inputs_count
+        self.unread = sum(self.essential)
+        for a, b in prefix:
+            self._push(a, b, self.mask ^ (self.tables[a] & self.tables[b]))
+
+    def _push(self, a: int, b: int, table: int):
+        for s in {a, b}:
+            if self.reads[s] == 0 and (s >= self.inputs_count or self.essential[s]):
+                self.unread -= 1
+            self.reads[s] += 1
+        self.tables.append(table)
+        self.existing.add(table)
+        self.reads.append(0)
+        self.unread += 1
+        self.gates.append((a, b))
+
+    def _pop(self):
+        a, b = self.gates.pop()
+        self.reads.pop()
+        self.unread -= 1
+        self.existing.discard(self.tables.pop())
+        for s in {a, b}:
+            self.reads[s] -= 1
+            if self.reads[s] == 0 and (s >= self.inputs_count or self.essential[s]):
+                self.unread += 1
+
+    def _candidates(self) -> List[Tuple[int, int, int]]:
+        """The gates which can be added to the current network, and their tables."""
+        tables, reads = self.tables, self.reads
+        n = len(tables)
+        remaining = self.gates_count - len(self.gates) - 1
+        last = remaining == 0
+        previous = tables[n - 1] if len(self.gates) != 0 else -1
+        # The output is 'NAND(a, b)' with 'a & b == NOT target': both its inputs
+        # include 'NOT target', and the gate before it is one of them.
+        complement = self.mask ^ self.target
+        signals = range(n)
+        if last:
+            signals = [s for s in signals if tables[s] & complement == complement]
+        candidates: List[Tuple[int, int, int]] = []
+        for idx, a in enumerate(signals):
+            table_a = tables[a]
+            for b in signals[idx:]:
+                table = self.mask ^ (table_a & tables[b])
+                if last != (table == self.target) or table in self.existing:
+                    continue
+                if remaining == 1 and table & complement != complement:
+                    continue
+                # The output is always the last gate, the others are ordered.
+                if not last and table < previous and b != n - 1:
+                    continue
+                # The signals still unread once the gate is added, itself included.
+                newly_read = sum(
+                    1
+                    for s in {a, b}
+                    if reads[s] == 0 and (s >= self.inputs_count or self.essential[s])
+                )
+                if self.unread - newly_read + 1 - remaining > 1:
+                    continue
+                candidates.append((a, b, table))
+        return candidates
+
+    def children(self, prefix: List[Gate]) -> List[Gate]:
+        """The gates which can be added after the given ones."""
+        self._reset(prefix)
+        return [(a, b) for a, b, _ in self._candidates()]
+
+    def run(self, prefix: List[Gate]) -> Optional[List[Gate]]:
+        """The first network starting with the prefix, if any."""
+        self._reset(prefix)
+        return self._run()
+
+    def _run(self) -> Optional[List[Gate]]:
+        if len(self.gates) == self.gates_count:
+            return list(self.gates)
+        for a, b, table in self._candidates():
+            self._push(a, b, table)
+            found = self._run()
+            self._pop()
+            if found is not None:
+                return found
+        return None
+
+
+def _swap_cofactors(table: int, input_table: int) -> int:
+    """The table with the vectors where the input is 0 and 1 exchanged: the table
+    itself if and only if it doesn't depend on the input."""
+    shift = (input_table & -input_table).bit_length() - 1
+    high = table & input_table
+    low = table & ~input_table
+    return (high >> shift) | (low << shift)
+
+
+def _search_prefix(
+    target: int, inputs_count: int, gates_count: int, prefix: List[Gate]
+) -> Optional[List[Gate]]:
+    return _Search(target, inputs_count, gates_count).run(prefix)
+
+
+def find_minimal_network(
+    table: int,
+    inputs_count: int,
+    max_gates: int = 12,
+    workers: int = 1,
+) -> Optional[NandNetwork]:
+    """Find a network with the fewest NAND gates computing a truth table.
+
+    The networks are enumerated by increasing number of gates, so the first one found
+    is minimal. The target is first replaced by the canonical function of its input
+    permutations: the functions identical up to the order of their inputs share the
+    same search, and the network found is permuted back.
+
+    With several workers, the search of each number of gates is split by the first
+    two gates of the networks. The prefixes are handed to the workers one at a time,
+    as they finish the previous ones, so the uneven subtrees are balanced.
+
+    Args:
+        table: The truth table, as for 'input_tables()'.
+        inputs_count: The number of inputs, at most 'MAX_INPUTS'.
+        max_gates: The number of gates after which the search gives up.
+        workers: The number of worker processes. With 1, everything is done in the
+        current process.
+
+    Returns:
+        A minimal network, or None if it needs more than 'max_gates' gates.
+    """
+    if not 1 <= inputs_count <= MAX_INPUTS:
+        raise ValueError(
+            f"The number of inputs must be between 1 and {MAX_INPUTS}, "
+            f"not {inputs_count}."
+        )
+    mask = (1 << (1 << inputs_count)) - 1
+    if table & ~mask:
+        raise ValueError(f"The truth table has more than {mask.bit_length()} bits.")
+    if workers < 1:
+        raise ValueError(f"The number of workers must be positive, not {workers}.")
+
+    canonical, permutation = canonical_table(table, inputs_count)
+    network = _CACHE.get((canonical, inputs_count))
+    if network is None:
+        network = _find_canonical(canonical, inputs_count, max_gates, workers)
+        if network is None:
+            return None
+        _CACHE[canonical, inputs_count] = network
+    return network.permuted(permutation)
+
+
+# The minimal networks already found, by canonical table and number of inputs.
+_CACHE: Dict[Tuple[int, int], NandNetwork] = {}
+
+
+def _find_canonical(
+    table: int, inputs_count: int, max_gates: int, workers: int
+) -> Optional[NandNetwork]:
+    tables = input_tables(inputs_count)
+    if table in tables:
+        return NandNetwork(inputs_count, [], tables.index(table))
+
+    for gates_count in range(1, max_gates + 1):
+        search = _Search(table, inputs_count, gates_count)
+        if workers == 1 or gates_count <= 2:
+            gates = search.run([])
+        else:
+            prefixes = [
+                [first, second]
+                for first in search.children([])
+                for second in search.children([first])
+            ]
+            gates = None
+            with ProcessPoolExecutor(max_workers=workers) as executor:
+                futures = [
+                    executor.submit(
+                        _search_prefix, table, inputs_count, gates_count, prefix
+                    )
+                    for prefix in prefixes
+                ]
+                # The first prefix in order, for a deterministic result.
+                for future in futures:
+                    gates = future.result()
+                    if gates is not None:
+                        for other in futures:
+                            other.cancel()
+                        break
+        if gates is not None:
+            return NandNetwork(inputs_count, gates, inputs_count + gates_count - 1)
+    return None
@@ -0,0 +1,335 @@
+import mmap
+import os
+import struct
+import sys
+from array import array
+from pathlib import Path
+from typing import Dict, List, Optional, Sequence, Tuple
+
+from bitarray import bitarray
+
+from nand.bit_packed_loader import BitPackedLoader
+from nand.disk_cache import cache_directory, hash_bits, write_atomically
+from nand.flat_netlist import FlatNetlist, flatten_definition, levelize
+from nand.optimization_level import OptimizationLevel
+from nand.simulator import Simulator
+from nand.simulator_builder import build_netlist_simulator
+
+# Part of the cache keys: to change when the format or the flattening changes.
+_NETLIST_CACHE_VERSION = "netlist-1"
+
+# The file starts with a magic, the number of netlists, and the byte offset of each
+# netlist. A netlist is its wires count, the lengths of its arrays, and then the
+# arrays: inputs, outputs, in_a, in_b, out, and levels. All little-endian 64 bits
+# integers, so the arrays are copied out of the mapped file without any parsing.
+NETLIST_MAGIC = b"NANDNET1"
+_HEADER = struct.Struct("<8sQ")
+_NETLIST_HEADER = struct.Struct("<5Q")
+_ITEM_SIZE = 8
+
+# The levels the netlists are cached for, and whether their simulator levelizes them.
+_LEVELIZED = {
+    OptimizationLevel.COMPILED: False,
+    OptimizationLevel.BIT_PARALLEL: False,
+    OptimizationLevel.NATIVE: True,
+    OptimizationLevel.GPU: True,
+}
+
+
+def netlist_cache_key(bits: bitarray, level: OptimizationLevel) -> str:
+    """Compute the cache key of the netlists of a bit-packed stream, for a level.
+
+    The levels simulating the same netlists share the same key: COMPILED and
+    BIT_PARALLEL, and the levelized NATIVE and GPU.
+    """
+    variant = "levelized" if _LEVELIZED[level] else "flat"
+    return hash_bits(bits, f"{_NETLIST_CACHE_VERSION}/{variant}")
+
+
+def netlists_to_bytes(netlists: Sequence[FlatNetlist]) -> bytes:
+    """Serialize netlists in the format read by 'NetlistFile'."""
+    records: List[bytes] = []
+    for netlist in netlists:
+        arrays = (
+            netlist.inputs,
+            netlist.outputs,
+            netlist.in_a,
+            netlist.in_b,
+            netlist.out,
+            netlist.levels,
+        )
+        record = [
+            _NETLIST_HEADER.pack(
+                netlist.wires_count,
+                len(netlist.inputs),
+                len(netlist.outputs),
+                netlist.nands_count,
+                len(netlist.levels),
+            )
+        ]
+        for values in arrays:
+            words = array("q", values)
+            if sys.byteorder != "little":
+                words.byteswap()
+            record.append(words.tobytes())
+        records.append(b"".join(record))
+
+    offset = _HEADER.size + _ITEM_SIZE * len(netlists)
+    offsets = []
+    for record in records:
+        offsets.append(offset)
+        offset += len(record)
+    header = _HEADER.pack(NETLIST_MAGIC, len(netlists))
+    return header + struct.pack(f"<{len(offsets)}Q", *offsets) + b"".join(records)
+
+
+class NetlistFile(Sequence[FlatNetlist]):
+    """The netlists of a file written by 'save_netlists()', loaded on demand.
+
+    The file is memory-mapped: opening it only reads its headers, and a netlist is a
+    copy of its arrays out of the mapped pages, checked and kept the first time it's
+    asked for. There isn't any decoding, nor any 'Circuit' object. An inconsistent
+    netlist raises a 'ValueError' when it's asked for.
+    """
+
+    def __init__(self, path: Path | str):
+        self.path = Path(path)
+        with open(self.path, "rb") as file:
+            # An empty file can't be mapped.
+            if os.fstat(file.fileno()).st_size < _HEADER.size:
+                raise ValueError(f"{self.path} is not a netlists file.")
+            self._data = mmap.mmap(file.fileno(), 0, access=mmap.ACCESS_READ)
+        # The netlists already loaded, by index.
+        self._loaded: Dict[int, FlatNetlist] = {}
+        try:
+            self._offsets = self._read_offsets()
+        except ValueError:
+            self.close()
+            raise
+
+    def _read_offsets(self) -> Tuple[int, ...]:
+        """Read the offsets of the netlists, and check that each one fits in the
+        file."""
+        size = len(self._data)
+        magic, count = _HEADER.unpack_from(self._data)
+        if magic != NETLIST_MAGIC or size < _HEADER.size + _ITEM_SIZE * count:
+            raise ValueError(f"{self.path} is not a netlists file.")
+        offsets = struct.unpack_from(f"<{count}Q", self._data, _HEADER.size)
+        for idx, offset in enumerate(offsets):
+            end = offset + _NETLIST_HEADER.size
+            if end > size or end + _ITEM_SIZE * sum(self._counts(offset)) > size:
+                raise ValueError(f"The netlist {idx} of {self.path} is truncated.")
+        return offsets
+
+    def _counts(self, offset: int) -> Tuple[int, ...]:
+        """The lengths of the arrays of the netlist at an offset."""
+        _, n_inputs, n_outputs, nands, n_levels = _NETLIST_HEADER.unpack_from(
+            self._data, offset
+        )
+        return (n_inputs, n_outputs, nands, nands, nands, n_levels)
+
+    def __len__(self) -> int:
+        return len(self._offsets)
+
+    def __getitem__(self, idx):  # type: ignore[override]
+        if isinstance(idx, slice):
+            return [self[i] for i in range(*idx.indices(len(self)))]
+        if not -len(self) <= idx < len(self):
+            raise IndexError(f"Netlist {idx} does not exist")
+        idx %= len(self)
+        if idx not in self._loaded:
+            self._loaded[idx] = self._load(idx)
+        return self._loaded[idx]
+
+    def _load(self, idx: int) -> FlatNetlist:
+        offset = self._offsets[idx]
+        wires_count = _NETLIST_HEADER.unpack_from(self._data, offset)[0]
+        counts = self._counts(offset)
+        offset += _NETLIST_HEADER.size
+
+        arrays: List[array] = []
+        for count in counts:
+            arrays.append(self._read_array(offset, count))
+            offset += _ITEM_SIZE * count
+        inputs, outputs, in_a, in_b, out, levels = arrays
+        # The wires must be in the state buffer, before checking the gates.
+        wires = (inputs, outputs, in_a, in_b, out)
+        if any(len(a) != 0 and (min(a) < 0 or max(a) >= wires_count) for a in wires):
+            raise ValueError(f"The netlist {idx} of {self.path} is corrupted.")
+        netlist = FlatNetlist()
+        netlist.wires_count = wires_count
+        netlist.inputs = inputs.tolist()
+        netlist.outputs = outputs.tolist()
+        netlist.in_a, netlist.in_b, netlist.out = in_a, in_b, out
+        netlist.levels = levels.tolist()
+        if not _is_well_formed(netlist):
+            raise ValueError(f"The netlist {idx} of {self.path} is corrupted.")
+        return netlist
+
+    def _read_array(self, offset: int, count: int) -> array:
+        words = array("q")
+        words.frombytes(self._data[offset : offset + _ITEM_SIZE * count])
+        if sys.byteorder != "little":
+            words.byteswap()
+        # The arrays of 'FlatNetlist' are of C longs, 32 bits on some platforms.
+        return words if words.itemsize == array("l").itemsize else array("l", words)
+
+    def close(self):
+        """Unmap the file. The netlists already loaded stay valid."""
+        self._data.close()
+
+    def __enter__(self) -> "NetlistFile":
+        return self
+
+    def __exit__(self, *exc_info):
+        self.close()
+
+
+def _is_well_formed(netlist: FlatNetlist) -> bool:
+    """Check that a netlist can be simulated as is, its wires being in the state
+    buffer.
+
+    The simulators, like the native kernel whose state buffer isn't initialized, only
+    read wires already written: each gate must read inputs of the circuit or outputs
+    of the gates before it (of the previous levels, if levelized), and write its own
+    wire. The outputs of the circuit must be written too.
+    """
+    gates_count = len(netlist.out)
+    levels = netlist.levels
+    if levels and (
+        levels[0] != 0
+        or levels[-1] != gates_count
+        or any(start > end for start, end in zip(levels, levels[1:]))
+    ):
+        return False
+
+    # The gate writing each wire, -1 for the inputs, None if not written.
+    written_by: List[Optional[int]] = [None] * netlist.wires_count
+    for wire in netlist.inputs:
+        written_by[wire] = -1
+    level = 0
+    for gate, (a, b, out) in enumerate(zip(netlist.in_a, netlist.in_b, netlist.out)):
+        # The first gate whose output can't be read by this one.
+        if levels:
+            while levels[level + 1] <= gate:
+                level += 1
+            first = levels[level]
+        else:
+            first = gate
+        source_a, source_b = written_by[a], written_by[b]
+        if source_a is None or source_a >= first or source_b is None:
+            return False
+        if source_b >= first or written_by[out] is not None:
+            return False
+        written_by[out] = gate
+    return all(written_by[wire] is not None for wire in netlist.outputs)
+
+
+def save_netlists(netlists: Sequence[FlatNetlist], path: Path | str):
+    """Save netlists in a file, to be opened by 'NetlistFile'."""
+    write_atomically(Path(path), netlists_to_bytes(netlists))
+
+
+def cached_netlists(
+    bits: bitarray, level: OptimizationLevel, use_cache: bool = True
+) -> Sequence[FlatNetlist]:
+    """Get the netlists of all the circuits of a bit-packed stream, from the disk
+    cache if possible.
+
+    The netlists are keyed by a hash of the stream and of the kind of netlists of the
+    level: a warm start only hashes the stream and maps the file of the netlists,
+    without building any circuit. A netlist is copied out of the file, and checked,
+    the first time it's asked for: an inconsistent netlist raises a 'ValueError'
+    then (see 'build_cached_simulator()', which builds the file again). A file whose
+    headers can't be read is built again right away. If the cache directory can't be
+    written, the netlists are built without being saved. On a miss, the stream is
+    loaded by 'BitPackedLoader', each circuit flattened, and levelized for NATIVE
+    and GPU, before being saved in the 'netlists' cache directory (see
+    'nand.disk_cache').
+
+    Args:
+        bits: The output of 'BitPackedEncoder'.
+        level: The optimization level the netlists are for: COMPILED, BIT_PARALLEL,
+        NATIVE, or GPU.
+        use_cache: If False, the netlists are always built and never saved.
+
+    Returns:
+        The netlist of each circuit, by index, the NAND gate being the first one. From
+        the cache, it's a 'NetlistFile', mapped until it's closed.
+    """
+    if level not in _LEVELIZED:
+        raise ValueError(f"The optimization level {level} isn't a netlist level.")
+    path: Optional[Path] = None
+    if use_cache:
+        try:
+            path = cache_directory("netlists") / f"{netlist_cache_key(bits, level)}.bin"
+            if path.exists():
+                return NetlistFile(path)
+        except (ValueError, OSError):
+            # A corrupted file is built again.
+            if path is not None:
+                _remove(path)
+    return _build_netlists(bits, level, path)
+
+
+def _build_netlists(
+    bits: bitarray, level: OptimizationLevel, path: Optional[Path]
+) -> List[FlatNetlist]:
+    """Build the netlists of a bit-packed stream, and save them if there's a path."""
+    definitions = BitPackedLoader().load(bits)
+    netlists = [flatten_definition(definition) for definition in definitions.values()]
+    if _LEVELIZED[level]:
+        netlists = [levelize(netlist) for netlist in netlists]
+    if path is not None:
+        try:
+            save_netlists(netlists, path)
+        except OSError:
+            # The cache can't be written: the netlists are only kept in memory.
+            pass
+    return netlists
+
+
+def _remove(path: Path):
+    try:
+        path.unlink(missing_ok=True)
+    except OSError:
+        pass
+
+
+def build_cached_simulator(
+    bits: bitarray,
+    level: OptimizationLevel,
+    identifier: Optional[int] = None,
+    use_cache: bool = True,
+) -> Simulator:
+    """Build the simulator of a circuit of a bit-packed stream, from the netlists of
+    the disk cache (see 'cached_netlists()').
+
+    On a warm start, only the netlist of the circuit is read from the file, and
+    checked. If it's inconsistent, the file is built again.
+
+    Args:
+        bits: The output of 'BitPackedEncoder'.
+        level: The optimization level: COMPILED, BIT_PARALLEL, NATIVE, or GPU.
+        identifier: The index of the circuit, the last one by default.
+        use_cache: If False, the netlists are always built and never saved.
+    """
+    netlists = cached_netlists(bits, level, use_cache)
+    if identifier is None:
+        identifier = len(netlists) - 1
+    if not 0 <= identifier < len(netlists):
+        raise ValueError(f"Circuit {identifier} does not exist")
+    if not isinstance(netlists, NetlistFile):
+        return build_netlist_simulator(netlists[identifier], level, str(identifier))
+
+    # Only the netlist of the circuit is copied out of the file, and checked.
+    with netlists:
+        try:
+            netlist: Optional[FlatNetlist] = netlists[identifier]
+        except ValueError:
+            netlist = None
+    if netlist is None:
+        # A corrupted netlist: the file is built again.
+        _remove(netlists.path)
+        netlist = _build_netlists(bits, level, netlists.path)[identifier]
+    return build_netlist_simulator(netlist, level, str(identifier))
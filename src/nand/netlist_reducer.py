@@ -0,0 +1,188 @@
+from dataclasses import dataclass
+from typing import Dict, List, Tuple
+
+from nand.flat_netlist import FlatNetlist
+
+# The constant signals, which aren't wires of the netlist, during the reduction.
+ZERO = -1
+ONE = -2
+
+
+@dataclass
+class ReductionStats:
+    """What 'reduce_netlist()' removed from a netlist.
+
+    Attributes:
+        nands_before: The number of NAND gates of the original netlist.
+        nands_after: The number of NAND gates of the reduced netlist.
+        merged: The gates identical to a previous one, i.e. reading the same wires.
+        double_inversions: The inversions of an inverted wire.
+        constants: The gates simplified by a constant input, or with complementary
+                   inputs.
+        dead: The gates driving no output, once the others were simplified.
+    """
+
+    nands_before: int = 0
+    nands_after: int = 0
+    merged: int = 0
+    double_inversions: int = 0
+    constants: int = 0
+    dead: int = 0
+
+    def __str__(self):
+        return (
+            f"{self.nands_before} -> {self.nands_after} NANDs "
+            f"({self.merged} merged, {self.double_inversions} double inversions, "
+            f"{self.constants} constants, {self.dead} dead)"
+        )
+
+
+def reduce_netlist(netlist: FlatNetlist) -> Tuple[FlatNetlist, ReductionStats]:
+    """Remove the redundant NAND gates of a netlist.
+
+    The gates are rebuilt in order, each one being simplified on the fly:
+    - a gate reading the same wires as a previous gate is this gate (structural
+      hashing),
+    - the inversion 'NAND(x, x)' of an inverted wire is the wire itself,
+    - a gate reading a constant, or a wire and its inversion, is a constant or an
+      inversion of its other input. The constants come from such gates: e.g.,
+      'x AND NOT x' is 0.
+    Then, the gates not driving any output are removed.
+
+    The reduced netlist computes the same outputs from the same inputs, but isn't
+    levelized anymore (see 'levelize()'). A constant output is computed from the first
+    input, as the netlist doesn't have any constant wire.
+
+    Args:
+        netlist: The netlist to reduce, in topological order.
+
+    Returns:
+        The reduced netlist, and the statistics of the reduction.
+
+    Raises:
+        ValueError: If an output is constant, and there isn't any input to compute it.
+    """
+    stats = ReductionStats(nands_before=netlist.nands_count)
+    builder = ReducedNetlistBuilder(stats)
+    outputs = builder.add_netlist(netlist, builder.add_inputs(len(netlist.inputs)))
+    if any(signal < 0 for signal in outputs):
+        outputs = builder.materialize_constants(outputs)
+
+    reduced = _remove_dead_gates(builder.netlist, outputs, stats)
+    stats.nands_after = reduced.nands_count
+    return reduced, stats
+
+
+class ReducedNetlistBuilder:
+    """Add the simplified NAND gates to a new netlist.
+
+    The gates of several netlists can be added on the same inputs: their identical
+    gates are then shared, e.g. to compare them (see 'nand.equivalence').
+
+    Attributes:
+        netlist: The netlist being built.
+        stats: The statistics of the reduction.
+        gates: The output of each gate, by its (sorted) inputs.
+        inversions: The wire inverted by each inversion gate, by its output.
+    """
+
+    def __init__(self, stats: ReductionStats):
+        self.netlist = FlatNetlist()
+        self.stats = stats
+        self.gates: Dict[Tuple[int, int], int] = {}
+        self.inversions: Dict[int, int] = {}
+
+    def add_inputs(self, count: int) -> List[int]:
+        """Add inputs to the netlist, and return their wires."""
+        wires = [self.netlist.add_wire() for _ in range(count)]
+        self.netlist.inputs += wires
+        return wires
+
+    def add_netlist(self, netlist: FlatNetlist, inputs: List[int]) -> List[int]:
+        """Add the simplified gates of a netlist, in topological order, on the given
+        signals as its inputs.
+
+        Returns:
+            The signal of each output of the netlist, a wire or a constant.
+        """
+        signals: List[int] = [ZERO] * netlist.wires_count
+        for idx, signal in zip(netlist.inputs, inputs):
+            signals[idx] = signal
+        for a, b, out in zip(netlist.in_a, netlist.in_b, netlist.out):
+            signals[out] = self.nand(signals[a], signals[b])
+        return [signals[idx] for idx in netlist.outputs]
+
+    def nand(self, a: int, b: int) -> int:
+        """The signal of 'NAND(a, b)', a wire or a constant."""
+        if a == ZERO or b == ZERO:
+            self.stats.constants += 1
+            return ONE
+        if a == ONE:
+            a, b = b, a
+        if b == ONE:
+            self.stats.constants += 1
+            return ZERO if a == ONE else self.invert(a, count=False)
+        if a == b:
+            return self.invert(a)
+        if self.inversions.get(a) == b or self.inversions.get(b) == a:
+            self.stats.constants += 1
+            return ONE
+        return self._add_gate(a, b)
+
+    def invert(self, a: int, count: bool = True) -> int:
+        """The signal of 'NAND(a, a)'."""
+        if a in self.inversions:
+            if count:
+                self.stats.double_inversions += 1
+            return self.inversions[a]
+        out = self._add_gate(a, a)
+        self.inversions[out] = a
+        return out
+
+    def _add_gate(self, a: int, b: int) -> int:
+        key = (a, b) if a <= b else (b, a)
+        out = self.gates.get(key)
+        if out is not None:
+            self.stats.merged += 1
+            return out
+        out = self.netlist.add_nand(a, b)
+        self.gates[key] = out
+        return out
+
+    def materialize_constants(self, signals: List[int]) -> List[int]:
+        """Replace the constants by wires computed from the first input."""
+        if len(self.netlist.inputs) == 0:
+            raise ValueError("A constant output needs an input to be computed from.")
+        first = self.netlist.inputs[0]
+        # Added directly: the builder would simplify them back into constants.
+        one = self.netlist.add_nand(first, self.invert(first, count=False))
+        zero = self.netlist.add_nand(one, one)
+        constants = {ZERO: zero, ONE: one}
+        return [constants.get(signal, signal) for signal in signals]
+
+
+def _remove_dead_gates(
+    netlist: FlatNetlist, outputs: List[int], stats: ReductionStats
+) -> FlatNetlist:
+    """A copy of the netlist without the gates not driving any output."""
+    live = [False] * netlist.wires_count
+    for idx in outputs:
+        live[idx] = True
+    # The gates are in topological order: the readers of a gate are after it.
+    for gate in reversed(range(netlist.nands_count)):
+        if live[netlist.out[gate]]:
+            live[netlist.in_a[gate]] = True
+            live[netlist.in_b[gate]] = True
+
+    reduced = FlatNetlist()
+    indices: Dict[int, int] = {}
+    for idx in netlist.inputs:
+        indices[idx] = reduced.add_wire()
+        reduced.inputs.append(indices[idx])
+    for a, b, out in zip(netlist.in_a, netlist.in_b, netlist.out):
+        if live[out]:
+            indices[out] = reduced.add_nand(indices[a], indices[b])
+        else:
+            stats.dead += 1
+    reduced.outputs = [indices[idx] for idx in outputs]
+    return reduced
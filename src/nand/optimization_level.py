@@ -4,3 +4,10 @@ from enum import Enum, auto
 class OptimizationLevel(Enum):
     DEBUG = auto()
     FAST = auto()
+    COMPILED = auto()
+    BIT_PARALLEL = auto()
+    NATIVE = auto()
+    INCREMENTAL = auto()
+    LOOKUP_TABLE = auto()
+    CODEGEN = auto()
+    GPU = auto()
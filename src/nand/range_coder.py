@@ -0,0 +1,272 @@
+from typing import Dict, List
+
+# The probabilities are 11 bits fixed-point numbers: the probability of a bit to be
+# 0 is 'p / 2048'. After each coded bit, it moves 1/32 of the way toward the value
+# of the bit.
+PROBABILITY_BITS = 11
+PROBABILITY_ONE = 1 << PROBABILITY_BITS
+ADAPTATION_SHIFT = 5
+INITIAL_PROBABILITY = PROBABILITY_ONE // 2
+
+# The adaptation of a probability after coding a 0 or a 1, precomputed for every
+# probability: coding a bit is then a multiplication, a comparison, and lookups. The
+# symbols themselves are still decoded bit by bit, as each bit changes the
+# probability of the next one.
+UPDATE_ZERO = [
+    p + ((PROBABILITY_ONE - p) >> ADAPTATION_SHIFT) for p in range(PROBABILITY_ONE)
+]
+UPDATE_ONE = [p - (p >> ADAPTATION_SHIFT) for p in range(PROBABILITY_ONE)]
+
+_TOP = 1 << 24
+_MASK = (1 << 32) - 1
+
+# The maximum bit length of the integers coded by 'IntegerModel'.
+MAX_INTEGER_BITLENGTH = 64
+
+
+class RangeEncoder:
+    """An adaptive binary range coder, as the one of LZMA.
+
+    Each bit is coded with a probability, stored in a list of the caller: the "model"
+    of the bit. The closer the probability to the value of the bit, the fewer output
+    bits it costs, down to a fraction of a bit.
+
+    The first byte of an LZMA stream is always 0, and the trailing zeros aren't
+    needed by the decoder (see 'RangeDecoder'), so they are removed.
+    """
+
+    def __init__(self):
+        self.low = 0
+        self.range = _MASK
+        self._cache = 0
+        self._cache_size = 1
+        self._output = bytearray()
+
+    def encode_bit(self, probabilities: List[int], idx: int, bit: int):
+        """Encode a bit with the probability 'probabilities[idx]', then adapt it."""
+        p = probabilities[idx]
+        bound = (self.range >> PROBABILITY_BITS) * p
+        if bit:
+            self.low += bound
+            self.range -= bound
+            probabilities[idx] = UPDATE_ONE[p]
+        else:
+            self.range = bound
+            probabilities[idx] = UPDATE_ZERO[p]
+        while self.range < _TOP:
+            self.range <<= 8
+            self._shift_low()
+
+    def finish(self) -> bytes:
+        for _ in range(5):
+            self._shift_low()
+        return bytes(self._output[1:].rstrip(b"\0"))
+
+    def _shift_low(self):
+        """Output the top byte of 'low', once it can't change with a carry anymore."""
+        if self.low < 0xFF000000 or self.low > _MASK:
+            carry = self.low >> 32
+            byte = self._cache
+            while self._cache_size:
+                self._output.append((byte + carry) & 0xFF)
+                byte = 0xFF
+                self._cache_size -= 1
+            self._cache = (self.low >> 24) & 0xFF
+        self._cache_size += 1
+        self.low = (self.low & 0x00FFFFFF) << 8
+
+
+class RangeDecoder:
+    """The decoder of 'RangeEncoder'. The bytes after the end of the data are 0.
+
+    The models decoding several bits in a row (see 'BitTreeModel' and
+    'IntegerModel') inline 'decode_bit', with 'range' and 'code' in local variables:
+    in Python, the calls and the attribute accesses cost more than the decoding
+    itself.
+    """
+
+    def __init__(self, data: bytes):
+        self._data = data
+        self._position = 0
+        self.range = _MASK
+        self.code = 0
+        for _ in range(4):
+            self.code = (self.code << 8) | self.next_byte()
+
+    def decode_bit(self, probabilities: List[int], idx: int) -> int:
+        """Decode a bit coded with the probability 'probabilities[idx]', then adapt
+        it."""
+        p = probabilities[idx]
+        bound = (self.range >> PROBABILITY_BITS) * p
+        if self.code < bound:
+            self.range = bound
+            probabilities[idx] = UPDATE_ZERO[p]
+            bit = 0
+        else:
+            self.code -= bound
+            self.range -= bound
+            probabilities[idx] = UPDATE_ONE[p]
+            bit = 1
+        while self.range < _TOP:
+            self.range <<= 8
+            self.code = ((self.code << 8) | self.next_byte()) & _MASK
+        return bit
+
+    def next_byte(self) -> int:
+        position = self._position
+        self._position += 1
+        return self._data[position] if position < len(self._data) else 0
+
+
+class BitModel:
+    """The probabilities of a set of binary decisions, one per context."""
+
+    def __init__(self, contexts_count: int):
+        self.probabilities = [INITIAL_PROBABILITY] * contexts_count
+
+    def encode(self, encoder: RangeEncoder, bit: int, context: int = 0):
+        encoder.encode_bit(self.probabilities, context, bit)
+
+    def decode(self, decoder: RangeDecoder, context: int = 0) -> int:
+        return decoder.decode_bit(self.probabilities, context)
+
+
+class BitTreeModel:
+    """The model of integers of a fixed bit length, most significant bit first.
+
+    Each bit is coded in the context of the bits before it: the nodes of a binary
+    tree. So, the model learns the distribution of the integers themselves.
+    """
+
+    def __init__(self, bitlength: int):
+        self.bitlength = bitlength
+        self.probabilities = [INITIAL_PROBABILITY] * (1 << bitlength)
+
+    def encode(self, encoder: RangeEncoder, value: int):
+        if value >> self.bitlength:
+            raise ValueError(
+                f"Integer {value} requires more than {self.bitlength} bits to represent"
+            )
+        node = 1
+        for shift in range(self.bitlength - 1, -1, -1):
+            bit = (value >> shift) & 1
+            encoder.encode_bit(self.probabilities, node, bit)
+            node = (node << 1) | bit
+
+    def decode(self, decoder: RangeDecoder) -> int:
+        # 'decoder.decode_bit(probabilities, node)' for each bit, inlined.
+        probabilities = self.probabilities
+        range_, code = decoder.range, decoder.code
+        node = 1
+        for _ in range(self.bitlength):
+            p = probabilities[node]
+            bound = (range_ >> PROBABILITY_BITS) * p
+            if code < bound:
+                range_ = bound
+                probabilities[node] = UPDATE_ZERO[p]
+                node <<= 1
+            else:
+                code -= bound
+                range_ -= bound
+                probabilities[node] = UPDATE_ONE[p]
+                node = (node << 1) | 1
+            while range_ < _TOP:
+                range_ <<= 8
+                code = ((code << 8) | decoder.next_byte()) & _MASK
+        decoder.range, decoder.code = range_, code
+        return node - (1 << self.bitlength)
+
+
+class BitTreeModels:
+    """Bit tree models by bit length, created on demand."""
+
+    def __init__(self):
+        self._models: Dict[int, BitTreeModel] = {}
+
+    def __getitem__(self, bitlength: int) -> BitTreeModel:
+        model = self._models.get(bitlength)
+        if model is None:
+            model = self._models[bitlength] = BitTreeModel(bitlength)
+        return model
+
+
+class IntegerModel:
+    """The model of unbounded non-negative integers: an adaptive Elias gamma code.
+
+    The bit length of 'value + 1' is coded in unary, each unary bit having its own
+    context. Then, the bits after the leading 1 are coded, in the context of the bit
+    length and their position. Small values cost a few bits, and the frequent values
+    quickly cost less than a bit.
+    """
+
+    def __init__(self):
+        self._lengths = [INITIAL_PROBABILITY] * MAX_INTEGER_BITLENGTH
+        # The context of the i-th bit of a n bits value is 'n * (n - 1) / 2 + i'.
+        self._bits = [INITIAL_PROBABILITY] * (
+            MAX_INTEGER_BITLENGTH * (MAX_INTEGER_BITLENGTH + 1) // 2
+        )
+
+    def encode(self, encoder: RangeEncoder, value: int):
+        if value < 0:
+            raise ValueError("Input must be a non-negative integer")
+        value += 1
+        bitlength = value.bit_length()
+        if bitlength >= MAX_INTEGER_BITLENGTH:
+            raise ValueError(f"Integer {value - 1} is too large to be encoded.")
+        for idx in range(bitlength - 1):
+            encoder.encode_bit(self._lengths, idx, 1)
+        encoder.encode_bit(self._lengths, bitlength - 1, 0)
+
+        base = bitlength * (bitlength - 1) // 2
+        for idx in range(bitlength - 1):
+            bit = (value >> (bitlength - 2 - idx)) & 1
+            encoder.encode_bit(self._bits, base + idx, bit)
+
+    def decode(self, decoder: RangeDecoder) -> int:
+        # 'decoder.decode_bit()' for each bit, inlined.
+        range_, code = decoder.range, decoder.code
+
+        lengths = self._lengths
+        bitlength = 0
+        while True:
+            p = lengths[bitlength]
+            bound = (range_ >> PROBABILITY_BITS) * p
+            if code < bound:
+                range_ = bound
+                lengths[bitlength] = UPDATE_ZERO[p]
+                bit = 0
+            else:
+                code -= bound
+                range_ -= bound
+                lengths[bitlength] = UPDATE_ONE[p]
+                bit = 1
+            while range_ < _TOP:
+                range_ <<= 8
+                code = ((code << 8) | decoder.next_byte()) & _MASK
+            bitlength += 1
+            if not bit:
+                break
+            if bitlength + 1 >= MAX_INTEGER_BITLENGTH:
+                raise ValueError("The encoded integer is too large.")
+
+        bits = self._bits
+        value = 1
+        for idx in range(
+            bitlength * (bitlength - 1) // 2, bitlength * (bitlength + 1) // 2 - 1
+        ):
+            p = bits[idx]
+            bound = (range_ >> PROBABILITY_BITS) * p
+            if code < bound:
+                range_ = bound
+                bits[idx] = UPDATE_ZERO[p]
+                value <<= 1
+            else:
+                code -= bound
+                range_ -= bound
+                bits[idx] = UPDATE_ONE[p]
+                value = (value << 1) | 1
+            while range_ < _TOP:
+                range_ <<= 8
+                code = ((code << 8) | decoder.next_byte()) & _MASK
+        decoder.range, decoder.code = range_, code
+        return value - 1
@@ -0,0 +1,166 @@
+from abc import ABC, abstractmethod
+from typing import List, Optional, Sequence
+
+from nand.circuit import Circuit
+from nand.flat_netlist import FlatNetlist
+from nand.simulator_compiled import SimulatorCompiled
+
+
+type BatchInputs = Sequence[Sequence[bool]]
+type BatchResult = List[List[bool]]
+
+
+class BatchSimulator(ABC):
+    """Interface of the simulators able to evaluate many input vectors in a single
+    pass.
+
+    The input vectors are packed into words: each bit of a word, or "lane", is the
+    state of a wire for an independent input vector. The words are Python integers.
+
+    Attributes:
+        lanes: The default number of input vectors evaluated per pass.
+    """
+
+    lanes: int
+
+    @abstractmethod
+    def simulate_words(self, inputs: Sequence[int], lanes: int) -> List[int]:
+        """Simulate the circuit with the given packed inputs.
+
+        Args:
+            inputs: For each input of the circuit, a word whose k-th bit is the value
+            of this input for the k-th input vector.
+            lanes: The number of input vectors packed in the words.
+
+        Returns:
+            For each output of the circuit, a word whose k-th bit is the value of this
+            output for the k-th input vector.
+        """
+        pass
+
+    def simulate_counter(self, n_inputs: int, start: int, lanes: int) -> List[int]:
+        """Simulate the vectors 'start' to 'start + lanes - 1', the i-th input being
+        the i-th bit of the vector index (see 'counter_inputs()').
+
+        Returns:
+            The packed outputs, as for 'simulate_words()'.
+        """
+        return self.simulate_words(counter_inputs(n_inputs, start, lanes), lanes)
+
+    def simulate_batch(self, inputs: BatchInputs) -> BatchResult:
+        """Simulate the circuit for a batch of input vectors.
+
+        Args:
+            inputs: A matrix of inputs: one row per input vector, one column per input
+            of the circuit.
+
+        Returns:
+            A matrix of outputs: one row per input vector, one column per output of the
+            circuit.
+        """
+        results: BatchResult = []
+        for start in range(0, len(inputs), self.lanes):
+            chunk = inputs[start : start + self.lanes]
+            outputs = self.simulate_words(pack_lanes(chunk), len(chunk))
+            results.extend(unpack_lanes(outputs, len(chunk)))
+        return results
+
+
+class SimulatorBitParallel(SimulatorCompiled, BatchSimulator):
+    """A simulator evaluating many input vectors in a single pass.
+
+    Each wire holds a word instead of a boolean: each bit of the word, or "lane", is
+    the state of the wire for an independent input vector. A NAND gate is then
+    evaluated for all the lanes at once with bitwise operations.
+
+    The words are Python integers, so there isn't any hard limit on the number of
+    lanes. The larger the words are, the more the cost of the interpreter is amortized.
+
+    The single vector 'simulate()' is the one of the compiled simulator, as it is
+    faster than a pass with a single lane.
+    """
+
+    DEFAULT_LANES = 1024
+
+    def __init__(
+        self,
+        circuit: Circuit,
+        lanes: int = DEFAULT_LANES,
+        netlist: Optional[FlatNetlist] = None,
+    ):
+        super().__init__(circuit, netlist)
+        if lanes < 1:
+            raise ValueError(f"The number of lanes must be positive, not {lanes}.")
+        self.lanes = lanes
+        self._words: List[int] = [0] * self._netlist.wires_count
+
+    @property
+    def words(self) -> List[int]:
+        """The word of each wire of the netlist, from the last simulation."""
+        return self._words
+
+    def simulate_words(self, inputs: Sequence[int], lanes: int) -> List[int]:
+        """Simulate the circuit with the given packed inputs (see 'BatchSimulator')."""
+        mask = (1 << lanes) - 1
+        words = self._words
+        for idx, word in zip(self._netlist.inputs, inputs):
+            words[idx] = word & mask
+
+        # As the inputs are masked, 'a & b' is too, so the NOT can be a XOR
+        # with the mask.
+        for a, b, out in self._nands:
+            words[out] = mask ^ (words[a] & words[b])
+
+        self._was_simulated = True
+
+        return [words[idx] for idx in self._netlist.outputs]
+
+
+def pack_lanes(vectors: BatchInputs) -> List[int]:
+    """Transpose a matrix of vectors into one word per column, the k-th vector
+    being the k-th bit of the words.
+    """
+    # The string conversion is done by the interpreter in native code, which is much
+    # faster than shifting and or-ing the bits one by one.
+    return [
+        int("".join("1" if bit else "0" for bit in reversed(column)), 2)
+        for column in zip(*vectors)
+    ]
+
+
+def unpack_lanes(words: Sequence[int], lanes: int) -> BatchResult:
+    """Transpose one word per column back into a matrix of 'lanes' vectors."""
+    columns = [
+        [bit == "1" for bit in reversed(format(word, f"0{lanes}b"))] for word in words
+    ]
+    return [list(row) for row in zip(*columns)]
+
+
+def counter_inputs(n_inputs: int, start: int, lanes: int) -> List[int]:
+    """Generate the packed inputs of the vectors 'start' to 'start + lanes - 1'.
+
+    The i-th input is the i-th bit of the vector index. If 'start' is a multiple of
+    'lanes', which is a power of two, the low inputs are periodic patterns and the high
+    inputs are constants, so the words are built without enumerating the vectors.
+    """
+    if lanes & (lanes - 1) == 0 and start % lanes == 0:
+        period_bits = lanes.bit_length() - 1
+        all_ones = (1 << lanes) - 1
+        words = []
+        for i in range(n_inputs):
+            if i < period_bits:
+                # 2^i zeros then 2^i ones, repeated.
+                block = ((1 << (1 << i)) - 1) << (1 << i)
+                period = 1 << (i + 1)
+                words.append(block * (all_ones // ((1 << period) - 1)))
+            else:
+                words.append(all_ones if (start >> i) & 1 else 0)
+        return words
+
+    words = [0] * n_inputs
+    for k in range(lanes):
+        vector = start + k
+        for i in range(n_inputs):
+            if (vector >> i) & 1:
+                words[i] |= 1 << k
+    return words
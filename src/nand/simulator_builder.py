@@ -1,15 +1,86 @@
+from typing import Optional
+
+from nand.circuits_library import CircuitLibrary
+from nand.flat_netlist import FlatNetlist, flatten
+from nand.netlist_reducer import reduce_netlist
 from nand.simulator import Circuit, Simulator
 from nand.simulator_debug import SimulatorDebug
 from nand.simulator_fast import SimulatorFast
+from nand.simulator_compiled import SimulatorCompiled
+from nand.simulator_bit_parallel import SimulatorBitParallel
+from nand.simulator_native import SimulatorNative
+from nand.simulator_incremental import SimulatorIncremental
+from nand.simulator_lookup_table import SimulatorLookupTable
+from nand.simulator_codegen import SimulatorCodegen
+from nand.simulator_gpu import SimulatorGpu
 from nand.optimization_level import OptimizationLevel
 
 
-def build_simulator(circuit: Circuit, level: OptimizationLevel) -> Simulator:
-    """Build a simulator according to the optimization level."""
+def build_simulator(
+    circuit: Circuit,
+    level: OptimizationLevel,
+    reduce: bool = False,
+    library: Optional[CircuitLibrary] = None,
+) -> Simulator:
+    """Build a simulator according to the optimization level.
+
+    Args:
+        circuit: The circuit to simulate.
+        level: The optimization level.
+        reduce: Whether to remove the redundant gates of the flat netlist first (see
+        'reduce_netlist()'). Only for the levels simulating flat netlists: COMPILED,
+        BIT_PARALLEL, NATIVE, and GPU.
+        library: The library the circuit comes from. For LOOKUP_TABLE, the tables
+        are computed from its circuits, once for all the simulators of the library.
+    """
+    if reduce:
+        netlist, _ = reduce_netlist(flatten(circuit))
+        return build_netlist_simulator(netlist, level, str(circuit.identifier))
     match level:
         case OptimizationLevel.DEBUG:
             return SimulatorDebug(circuit)
         case OptimizationLevel.FAST:
             return SimulatorFast(circuit)
+        case OptimizationLevel.COMPILED:
+            return SimulatorCompiled(circuit)
+        case OptimizationLevel.BIT_PARALLEL:
+            return SimulatorBitParallel(circuit)
+        case OptimizationLevel.NATIVE:
+            return SimulatorNative(circuit)
+        case OptimizationLevel.INCREMENTAL:
+            return SimulatorIncremental(circuit)
+        case OptimizationLevel.LOOKUP_TABLE:
+            return SimulatorLookupTable(circuit, library)
+        case OptimizationLevel.CODEGEN:
+            return SimulatorCodegen(circuit)
+        case OptimizationLevel.GPU:
+            return SimulatorGpu(circuit)
         case _:
             raise ValueError("Unknown OptimizationLevel.")
+
+
+def build_netlist_simulator(
+    netlist: FlatNetlist, level: OptimizationLevel, identifier: str = "netlist"
+) -> Simulator:
+    """Build a simulator of an already flat netlist, without any circuit.
+
+    Only the optimization levels simulating flat netlists are available: COMPILED,
+    BIT_PARALLEL, NATIVE, and GPU.
+
+    Args:
+        netlist: The netlist to simulate.
+        level: The optimization level.
+        identifier: The identifier of the placeholder circuit of the simulator.
+    """
+    circuit = Circuit(identifier)
+    match level:
+        case OptimizationLevel.COMPILED:
+            return SimulatorCompiled(circuit, netlist)
+        case OptimizationLevel.BIT_PARALLEL:
+            return SimulatorBitParallel(circuit, netlist=netlist)
+        case OptimizationLevel.NATIVE:
+            return SimulatorNative(circuit, netlist=netlist)
+        case OptimizationLevel.GPU:
+            return SimulatorGpu(circuit, netlist=netlist)
+        case _:
+            raise ValueError(f"The optimization level {level} needs a circuit.")
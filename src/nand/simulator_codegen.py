@@ -0,0 +1,171 @@
+import importlib.util
+from pathlib import Path
+from typing import Callable, List, Optional, Sequence
+
+from nand.bit_packed_encoder import BitPackedEncoder
+from nand.circuit import Circuit
+from nand.circuits_library import library_from_circuit
+from nand.disk_cache import cache_directory, hash_bits, write_atomically
+from nand.flat_netlist import FlatNetlist, flatten
+from nand.simulator import SimulationResult, Simulator
+
+# Part of the cache keys: to change when the generated code changes.
+_CODEGEN_VERSION = "python-1"
+
+type GeneratedFunction = Callable[..., List[bool]]
+
+
+def generate_python_source(netlist: FlatNetlist, name: str = "simulate") -> str:
+    """Generate the source of a straight-line Python function simulating a netlist.
+
+    The function takes the inputs of the circuit as positional arguments, and returns
+    the list of its outputs. Each wire is a local variable, and each NAND gate a single
+    assignment: there isn't any indirection left.
+
+    Args:
+        netlist: The netlist to generate the code of, in topological order.
+        name: The name of the generated function.
+    """
+    arguments = ", ".join(f"w{idx}" for idx in netlist.inputs)
+    lines = [f"def {name}({arguments}):"]
+    for a, b, out in zip(netlist.in_a, netlist.in_b, netlist.out):
+        lines.append(f"    w{out} = not (w{a} and w{b})")
+    outputs = ", ".join(f"w{idx}" for idx in netlist.outputs)
+    lines.append(f"    return [{outputs}]")
+    return "\n".join(lines) + "\n"
+
+
+def circuit_cache_key(circuit: Circuit) -> Optional[str]:
+    """Compute the cache key of a circuit, from its bit-packed encoding.
+
+    The encoding only depends on the structure of the circuit and the order of its
+    components, not on the identity of its wires, so two builds of the same circuit
+    get the same key.
+
+    Returns:
+        The key, or None if the circuit can't be encoded (e.g. an output directly
+        connected to an input).
+    """
+    try:
+        bits = BitPackedEncoder().encode(library_from_circuit(circuit))
+    except ValueError:
+        return None
+    return hash_bits(bits, _CODEGEN_VERSION)
+
+
+def load_generated_function(
+    circuit: Circuit, netlist: FlatNetlist, use_cache: bool = True
+) -> GeneratedFunction:
+    """Get the generated function of a circuit, from the disk cache if possible.
+
+    The source is saved in the 'codegen' cache directory as a module. It's imported
+    like any other module, so the interpreter also caches its bytecode.
+
+    Args:
+        circuit: The circuit, already optimized, used for the cache key.
+        netlist: The flat netlist of the circuit, used to generate the code.
+        use_cache: If False, the code is always generated and never saved. The code
+        isn't saved either if the cache can't be written, e.g. in a read-only home.
+    """
+    key = circuit_cache_key(circuit) if use_cache else None
+    if key is None:
+        return _compile_function(circuit, netlist)
+
+    try:
+        path = cache_directory("codegen") / f"nand_{key}.py"
+        if not path.exists():
+            write_atomically(path, generate_python_source(netlist).encode())
+        return _import_function(path)
+    except OSError:
+        return _compile_function(circuit, netlist)
+
+
+def _compile_function(circuit: Circuit, netlist: FlatNetlist) -> GeneratedFunction:
+    namespace: dict = {}
+    source = generate_python_source(netlist)
+    exec(compile(source, f"<codegen {circuit.identifier}>", "exec"), namespace)
+    return namespace["simulate"]
+
+
+def _import_function(path: Path) -> GeneratedFunction:
+    spec = importlib.util.spec_from_file_location(path.stem, path)
+    if spec is None or spec.loader is None:
+        raise ImportError(f"Can't load the generated code {path}.")
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module.simulate
+
+
+class SimulatorCodegen(Simulator):
+    """A simulator running code generated specifically for the circuit.
+
+    The circuit is flattened, and then turned into a straight-line Python function:
+    every NAND gate is one expression on local variables. Compared to the compiled
+    simulator, there isn't any loop, nor any load of wire indices.
+
+    Generating and compiling the code is slow for large circuits, so it is cached on
+    disk, keyed by a hash of the bit-packed encoding of the circuit (see
+    'nand.disk_cache' for the location of the cache).
+
+    Like the fast simulator, it assumes the circuit is correctly defined, but
+    a missing connection is detected during compilation.
+    """
+
+    def __init__(self, circuit: Circuit, use_cache: bool = True):
+        super().__init__(circuit)
+
+        self._netlist: FlatNetlist = flatten(self._circuit)
+        self._use_cache = use_cache
+        self._function = load_generated_function(
+            self._circuit, self._netlist, self._use_cache
+        )
+        self._n_inputs = len(self._netlist.inputs)
+        self._last_inputs: List[bool] = [False] * self._n_inputs
+        self._last_outputs: List[bool] = []
+
+    def __getstate__(self):
+        """The generated function can't be pickled, but it can be loaded again, for
+        example to send the simulator to another process."""
+        state = self.__dict__.copy()
+        del state["_function"]
+        return state
+
+    def __setstate__(self, state):
+        self.__dict__.update(state)
+        self._function = load_generated_function(
+            self._circuit, self._netlist, self._use_cache
+        )
+
+    @property
+    def netlist(self) -> FlatNetlist:
+        return self._netlist
+
+    def simulate(self, inputs: Sequence[bool]) -> SimulationResult:
+        """Simulate the circuit with the given inputs.
+
+        Args:
+            inputs: The input values to simulate.
+
+        Returns:
+            The output values of the circuit.
+        """
+        self._last_inputs = [bool(input) for input in inputs[: self._n_inputs]]
+        self._last_outputs = self._function(*self._last_inputs)
+        self._was_simulated = True
+        return self._last_outputs
+
+    def _simulate(self, circuit: Circuit) -> bool:
+        """Unused: the simulation is done by the generated function."""
+        raise NotImplementedError("The simulation is done by the generated function.")
+
+    def _reset(self, circuit: Circuit):
+        """noop: the generated function doesn't have any state."""
+        pass
+
+    def __str__(self):
+        """Return a simple string representation of the simulator, using the last
+        simulated values as the wires of the circuit are not used for simulation."""
+        ins = "".join("1" if value else "0" for value in self._last_inputs)
+        outs = "".join("1" if value else "0" for value in self._last_outputs)
+        simulated = "simulated" if self._was_simulated else "not simulated"
+        return f"{self._circuit.identifier} {simulated}: {ins} -> {outs}"
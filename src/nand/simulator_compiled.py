@@ -0,0 +1,80 @@
+from typing import List, Optional, Sequence, Tuple
+
+from nand.circuit import Circuit
+from nand.flat_netlist import FlatNetlist, flatten
+from nand.simulator import SimulationResult, Simulator
+
+
+class SimulatorCompiled(Simulator):
+    """A simulator running a flattened version of the circuit.
+
+    The circuit is compiled once into a flat netlist of NAND gates. A simulation is
+    then a single loop over the gates, reading and writing a dense state buffer. There
+    isn't any walk of the circuit hierarchy anymore.
+
+    Like the fast simulator, it assumes the circuit is correctly defined, but
+    a missing connection is detected during compilation.
+
+    An already flat netlist can be given instead of flattening the circuit, e.g. one
+    loaded directly from an encoded library.
+    """
+
+    def __init__(self, circuit: Circuit, netlist: Optional[FlatNetlist] = None):
+        super().__init__(circuit)
+
+        self._netlist: FlatNetlist = (
+            flatten(self._circuit) if netlist is None else netlist
+        )
+
+        # Everything the simulation loop needs is prepared once.
+        self._state: List[bool] = [False] * self._netlist.wires_count
+        self._nands: List[Tuple[int, int, int]] = list(
+            zip(self._netlist.in_a, self._netlist.in_b, self._netlist.out)
+        )
+
+    @property
+    def netlist(self) -> FlatNetlist:
+        return self._netlist
+
+    def simulate(self, inputs: Sequence[bool]) -> SimulationResult:
+        """Simulate the circuit with the given inputs.
+
+        Args:
+            inputs: The input values to simulate.
+
+        Returns:
+            The output values of the circuit.
+        """
+        state = self._state
+        for idx, input in zip(self._netlist.inputs, inputs):
+            state[idx] = input
+
+        self._simulate(self._circuit)
+        self._was_simulated = True
+
+        return [state[idx] for idx in self._netlist.outputs]
+
+    def _simulate(self, circuit: Circuit) -> bool:
+        """Simulate the flat netlist.
+
+        Returns:
+            bool: systematically True: there's no check of simulation failure.
+        """
+        state = self._state
+        for a, b, out in self._nands:
+            state[out] = not (state[a] and state[b])
+        return True
+
+    def _reset(self, circuit: Circuit):
+        """noop: only the inputs are set before simulating."""
+        pass
+
+    def __str__(self):
+        """Return a simple string representation of the simulator, using the state
+        buffer as the wires of the circuit are not used for simulation."""
+        ins = "".join("1" if self._state[idx] else "0" for idx in self._netlist.inputs)
+        outs = "".join(
+            "1" if self._state[idx] else "0" for idx in self._netlist.outputs
+        )
+        simulated = "simulated" if self._was_simulated else "not simulated"
+        return f"{self._circuit.identifier} {simulated}: {ins} -> {outs}"
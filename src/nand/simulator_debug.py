@@ -1,19 +1,139 @@
-from typing import List
-from nand.circuit import Circuit
+from collections import deque
+from typing import Dict, List, NamedTuple, Tuple
 
+from nand.circuit import Circuit, CircuitId, InputId
 from nand.simulator import Simulator
 from nand.wire_converter import convert_wires
 from nand.optimization_level import OptimizationLevel
+from nand.wire_debug import WireDebug
 from nand.wire_extended_state import WireExtendedState
 
 
+class UnresolvedComponent(NamedTuple):
+    """A component left unresolved by a simulation.
+
+    Attributes:
+        path: The keys of the components from the simulated circuit to this one.
+        identifier: The identifier of the component circuit.
+        unknown_inputs: The inputs of the component whose state is still unknown.
+    """
+
+    path: Tuple[CircuitId, ...]
+    identifier: CircuitId
+    unknown_inputs: Tuple[InputId, ...]
+
+
+class _Schedule:
+    """The dependencies between the components of a circuit, computed once.
+
+    A component is ready once all its distinct input wires are known. The wires
+    known from the start are the inputs of the circuit; the others only through the
+    outputs of the components.
+
+    Attributes:
+        components: The keys and the components of the circuit, in order.
+        outputs: The outputs of each component: the index of their state in the
+                 buffer of the simulator, and the components reading them.
+        pending: The number of unknown input wires of each component, once the
+                 inputs of the circuit are known.
+        ready: The components ready once the inputs of the circuit are known.
+    """
+
+    def __init__(self, circuit: Circuit, indices: Dict[int, int]):
+        self.components: List[Tuple[CircuitId, Circuit]] = list(
+            circuit.components.items()
+        )
+        readers: Dict[int, List[int]] = {}
+        self.pending: List[int] = []
+        for idx, (_, component) in enumerate(self.components):
+            wire_ids = {wire.id for wire in component.inputs.values()}
+            for wire_id in wire_ids:
+                readers.setdefault(wire_id, []).append(idx)
+            self.pending.append(len(wire_ids))
+        # A wire exposed on several outputs is known once. An input passed through
+        # to an output was already known before the component.
+        self.outputs: List[List[Tuple[int, List[int]]]] = []
+        for _, component in self.components:
+            inputs = {wire.id for wire in component.inputs.values()}
+            wires = {
+                wire.id: wire
+                for wire in component.outputs.values()
+                if wire.id not in inputs
+            }
+            self.outputs.append(
+                [(indices[wire_id], readers.get(wire_id, [])) for wire_id in wires]
+            )
+
+        for wire_id in {wire.id for wire in circuit.inputs.values()}:
+            for reader in readers.get(wire_id, ()):
+                self.pending[reader] -= 1
+        self.ready = [idx for idx, count in enumerate(self.pending) if count == 0]
+
+
 class SimulatorDebug(Simulator):
-    """A simulator using a cautious approach to simulate a circuit."""
+    """A simulator using a cautious approach to simulate a circuit.
+
+    The states of the wires can be unknown: a component is only simulated once all its
+    inputs are known. The components are scheduled as their inputs become known, from
+    dependencies computed once per circuit: they don't need to be in a topological
+    order. A component never scheduled is part of a loop, or reads a wire driven by
+    nothing: the circuit is incorrect, and the component is reported in 'unresolved'.
+
+    All the wires share a single buffer of states, reset at once before each
+    simulation.
+
+    Attributes:
+        unresolved: The components left unresolved by the last simulation, the ones
+                    inside a component before the component itself. Empty if the
+                    simulation succeeded.
+    """
 
     def __init__(self, circuit: Circuit):
         super().__init__(circuit)
         convert_wires(self._circuit, OptimizationLevel.DEBUG)
 
+        self._prepare()
+        self._path: List[CircuitId] = []
+        self.unresolved: List[UnresolvedComponent] = []
+
+    def _prepare(self):
+        """Bind the wires to the shared buffer, and compute the schedules."""
+        self._schedules: Dict[int, _Schedule] = {}
+        self._states: List[WireExtendedState] = []
+        indices: Dict[int, int] = {}
+        self._index_wires(self._circuit, indices)
+        self._build_schedules(self._circuit, indices)
+        self._unknown_states = [WireExtendedState.UNKNOWN] * len(self._states)
+
+    def __getstate__(self):
+        """The schedules are indexed by the identity of the circuits, which is lost
+        by pickling: they are computed again when loaded."""
+        state = self.__dict__.copy()
+        del state["_schedules"]
+        return state
+
+    def __setstate__(self, state):
+        self.__dict__.update(state)
+        self._prepare()
+
+    def _index_wires(self, circuit: Circuit, indices: Dict[int, int]):
+        """Bind all the wires to the shared buffer."""
+        for wire in list(circuit.inputs.values()) + list(circuit.outputs.values()):
+            if wire.id not in indices:
+                indices[wire.id] = len(self._states)
+                self._states.append(WireExtendedState.UNKNOWN)
+                assert isinstance(wire, WireDebug)
+                wire.bind_state(self._states, indices[wire.id])
+        for component in circuit.components.values():
+            self._index_wires(component, indices)
+
+    def _build_schedules(self, circuit: Circuit, indices: Dict[int, int]):
+        if circuit.identifier == 0:
+            return
+        self._schedules[id(circuit)] = _Schedule(circuit, indices)
+        for component in circuit.components.values():
+            self._build_schedules(component, indices)
+
     def _can_simulate(self, circuit: Circuit) -> bool:
         """Check if the circuit can be simulated, i.e. all inputs are determined."""
         return all(
@@ -24,49 +144,71 @@ class SimulatorDebug(Simulator):
         """Simulate the circuit.
 
         The is a "debug" simulation, meaning it can only fails if the circuit
-        is incorrect.
+        is incorrect. The inputs of the components are known when they are
+        scheduled: only the ones of the simulated circuit itself are checked.
 
         Returns:
             bool: True if simulation completed successfully (all components simulated)
             False if simulation cannot proceed further.
         """
         # If the inputs are not set, we cannot simulate the circuit.
-        if not self._can_simulate(circuit):
+        if circuit is self._circuit and not self._can_simulate(circuit):
+            self.unresolved.append(
+                UnresolvedComponent((), circuit.identifier, self._unknown(circuit))
+            )
             return False
 
         # Base case: the circuit is a NAND gate.
         if circuit.identifier == 0:
             return self._simulate_nand(circuit)
 
-        # Simulate all components.
-        # We use a "light" brute-force approach by repeatedly trying to simulate
-        # all components. A queue is used to remove from the components already
-        # simulated.
-        # This approach allows to simulate the circuit even if the components
-        # are not defined in topological order.
-        components_queue: List[Circuit] = list(circuit.components.values())
-        left = len(components_queue)
-        while True:
-            to_simulate = left
-            for _ in range(to_simulate):
-                component = components_queue.pop(0)
-                if not self._simulate(component):
-                    components_queue.append(component)
-            left = len(components_queue)
-
-            if to_simulate == left:
-                break
+        schedule = self._schedules[id(circuit)]
+        pending = schedule.pending.copy()
+        ready = deque(schedule.ready)
+        simulated = [False] * len(schedule.components)
+        simulated_count = 0
+        path = self._path
+        states = self._states
+        unknown = WireExtendedState.UNKNOWN
+        while len(ready) != 0:
+            idx = ready.popleft()
+            key, component = schedule.components[idx]
+            path.append(key)
+            if self._simulate(component):
+                simulated[idx] = True
+                simulated_count += 1
+            path.pop()
+
+            # Even an incorrect component may have computed some of its outputs.
+            for state_idx, readers in schedule.outputs[idx]:
+                if states[state_idx] is unknown:
+                    continue
+                for reader in readers:
+                    pending[reader] -= 1
+                    if pending[reader] == 0:
+                        ready.append(reader)
+
+        if simulated_count == len(simulated):
+            return True
 
         # If there are still components to simulate, the simulation failed.
-        return left == 0
+        for idx, (key, component) in enumerate(schedule.components):
+            if not simulated[idx]:
+                self.unresolved.append(
+                    UnresolvedComponent(
+                        (*path, key), component.identifier, self._unknown(component)
+                    )
+                )
+        return False
+
+    def _unknown(self, circuit: Circuit) -> Tuple[InputId, ...]:
+        return tuple(
+            input_id
+            for input_id, wire in circuit.inputs.items()
+            if wire.state == WireExtendedState.UNKNOWN
+        )
 
     def _reset(self, circuit: Circuit):
         """Reset the wires to a initial UNKNOWN state."""
-        for wire in circuit.inputs.values():
-            wire.state = WireExtendedState.UNKNOWN
-
-        for wire in circuit.outputs.values():
-            wire.state = WireExtendedState.UNKNOWN
-
-        for component in circuit.components.values():
-            self._reset(component)
+        self._states[:] = self._unknown_states
+        self.unresolved = []
@@ -15,8 +15,8 @@ class SimulatorFast(Simulator):
     def __init__(self, circuit: Circuit):
         super().__init__(circuit)
 
-        # Optimize the circuit to put it in a topological order.
-        optimize(self._circuit)
+        # The topological order of the components of each circuit.
+        self._orders = optimize(self._circuit)
 
         convert_wires(self._circuit, OptimizationLevel.FAST)
 
@@ -34,10 +34,10 @@ class SimulatorFast(Simulator):
             self._simulate_nand(circuit)
             return True
 
-        # The components are supposed to be in topological order, so a simple
-        # loop is enough.
-        for component in circuit.components.values():
-            self._simulate(component)
+        # In topological order, a simple loop is enough.
+        components = circuit.components
+        for key in self._orders[circuit.identifier].keys:
+            self._simulate(components[key])
 
         return True
 
@@ -0,0 +1,284 @@
+from typing import List, Optional, Sequence
+
+from nand.circuit import Circuit
+from nand.flat_netlist import FlatNetlist, flatten, levelize
+from nand.simulator import SimulationResult, Simulator
+from nand.simulator_bit_parallel import BatchSimulator
+
+# CuPy is optional: it's only available if installed with the 'gpu' extra, for the
+# CUDA version of the machine. It depends on NumPy, used for the host buffers.
+try:
+    import cupy  # type: ignore[import-not-found]
+    import numpy  # type: ignore[import-not-found]
+except ImportError:
+    cupy = None
+    numpy = None
+
+
+# The bit-planes are rows of 64 bits words, one row per wire.
+_WORD_SIZE = 64
+_THREADS_PER_BLOCK = 256
+# From this number of words per row, a single launch evaluates all the gates: each
+# thread walks the whole netlist for its own word. Below it, there aren't enough
+# threads to fill the GPU, and each level is launched separately instead.
+_FUSED_MIN_WORDS = 4096
+# The attributes living on the GPU, set by 'SimulatorGpu._upload()'.
+_DEVICE_ATTRIBUTES = (
+    "_in_a",
+    "_in_b",
+    "_out",
+    "_inputs",
+    "_outputs",
+    "_nand_level",
+    "_nand_fused",
+    "_counter_inputs",
+    "_state",
+)
+
+_KERNELS_SOURCE = r"""
+typedef unsigned long long word_t;
+
+extern "C" __global__ void nand_level(
+    const int* in_a, const int* in_b, const int* out,
+    int begin, int count, int words, word_t* state
+) {
+    long long i = (long long)blockIdx.x * blockDim.x + threadIdx.x;
+    if (i >= (long long)count * words) return;
+    long long gate = begin + i / words;
+    long long w = i % words;
+    state[(long long)out[gate] * words + w] =
+        ~(state[(long long)in_a[gate] * words + w]
+          & state[(long long)in_b[gate] * words + w]);
+}
+
+extern "C" __global__ void nand_fused(
+    const int* in_a, const int* in_b, const int* out,
+    int count, int words, word_t* state
+) {
+    long long w = (long long)blockIdx.x * blockDim.x + threadIdx.x;
+    if (w >= words) return;
+    for (int gate = 0; gate < count; ++gate) {
+        state[(long long)out[gate] * words + w] =
+            ~(state[(long long)in_a[gate] * words + w]
+              & state[(long long)in_b[gate] * words + w]);
+    }
+}
+
+// The i-th input is the i-th bit of the vector index, the k-th lane of the w-th
+// word being the vector '64 * (first_word + w) + k'.
+extern "C" __global__ void counter_inputs(
+    const int* inputs, int n_inputs, word_t first_word, int words, word_t* state
+) {
+    const word_t patterns[6] = {
+        0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+        0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL,
+    };
+    long long i = (long long)blockIdx.x * blockDim.x + threadIdx.x;
+    if (i >= (long long)n_inputs * words) return;
+    int input = i / words;
+    long long w = i % words;
+    word_t value;
+    if (input < 6) {
+        value = patterns[input];
+    } else if (input - 6 < 64) {
+        value = ((first_word + w) >> (input - 6)) & 1 ? ~0ULL : 0ULL;
+    } else {
+        value = 0;
+    }
+    state[(long long)inputs[input] * words + w] = value;
+}
+"""
+
+
+def is_gpu_available() -> bool:
+    """Check if CuPy is installed, and sees at least one CUDA device."""
+    if cupy is None:
+        return False
+    try:
+        return cupy.cuda.runtime.getDeviceCount() > 0
+    except cupy.cuda.runtime.CUDARuntimeError:
+        return False
+
+
+def _blocks(threads: int) -> int:
+    return -(-threads // _THREADS_PER_BLOCK)
+
+
+class SimulatorGpu(Simulator, BatchSimulator):
+    """A simulator running the flat netlist of the circuit on a CUDA GPU, with CuPy.
+
+    The circuit is compiled into a levelized flat netlist, uploaded once. The state
+    buffer is a bit-plane per wire, a row of 64 bits words resident in the memory of
+    the GPU: only the packed inputs are uploaded, and the packed outputs downloaded.
+    The gates of a level being independent, a level is a single kernel launch over
+    all its gates and all the words. With enough words, all the levels are fused into
+    a single launch, each thread evaluating the whole netlist for its own word.
+
+    The exhaustive sweeps don't even upload the inputs: 'simulate_counter()'
+    generates them on the GPU (see 'nand.truth_table').
+
+    A single vector simulation is a batch of one lane: the GPU is only worth it for
+    large batches.
+
+    Like for the compiled simulator, an already flat netlist can be given.
+    """
+
+    DEFAULT_LANES = 1 << 20
+
+    def __init__(
+        self,
+        circuit: Circuit,
+        lanes: int = DEFAULT_LANES,
+        netlist: Optional[FlatNetlist] = None,
+    ):
+        if not is_gpu_available():
+            raise RuntimeError(
+                "The GPU simulation needs CuPy and a CUDA device: "
+                "the package must be installed with the 'gpu' extra."
+            )
+        super().__init__(circuit)
+        if lanes < 1:
+            raise ValueError(f"The number of lanes must be positive, not {lanes}.")
+        self.lanes = lanes
+
+        if netlist is None:
+            netlist = flatten(self._circuit)
+        self._netlist: FlatNetlist = netlist if netlist.levels else levelize(netlist)
+        self._upload()
+
+    def _upload(self):
+        """Upload the netlist, and compile the kernels."""
+        netlist = self._netlist
+        self._in_a = cupy.asarray(numpy.asarray(netlist.in_a, dtype=numpy.int32))
+        self._in_b = cupy.asarray(numpy.asarray(netlist.in_b, dtype=numpy.int32))
+        self._out = cupy.asarray(numpy.asarray(netlist.out, dtype=numpy.int32))
+        self._inputs = cupy.asarray(numpy.asarray(netlist.inputs, dtype=numpy.int32))
+        self._outputs = cupy.asarray(numpy.asarray(netlist.outputs, dtype=numpy.int64))
+        module = cupy.RawModule(code=_KERNELS_SOURCE)
+        self._nand_level = module.get_function("nand_level")
+        self._nand_fused = module.get_function("nand_fused")
+        self._counter_inputs = module.get_function("counter_inputs")
+        # The state buffer, allocated for a number of words per row.
+        self._state = None
+        self._words = 0
+
+    def __getstate__(self):
+        """The device buffers and kernels can't be pickled, but they can be uploaded
+        again, for example to send the simulator to another process."""
+        state = self.__dict__.copy()
+        for name in _DEVICE_ATTRIBUTES:
+            del state[name]
+        return state
+
+    def __setstate__(self, state):
+        self.__dict__.update(state)
+        self._upload()
+
+    @property
+    def netlist(self) -> FlatNetlist:
+        return self._netlist
+
+    def _allocate(self, words: int):
+        """The state buffer, as one row of words per wire."""
+        if self._state is None or self._words != words:
+            self._state = cupy.zeros(
+                self._netlist.wires_count * words, dtype=cupy.uint64
+            )
+            self._words = words
+        return self._state
+
+    def simulate(self, inputs: Sequence[bool]) -> SimulationResult:
+        """Simulate the circuit with the given inputs.
+
+        Args:
+            inputs: The input values to simulate.
+
+        Returns:
+            The output values of the circuit.
+        """
+        outputs = self.simulate_words([int(bool(input)) for input in inputs], 1)
+        return [word == 1 for word in outputs]
+
+    def simulate_words(self, inputs: Sequence[int], lanes: int) -> List[int]:
+        """Simulate the circuit with the given packed inputs (see 'BatchSimulator')."""
+        words = -(-lanes // _WORD_SIZE)
+        state = self._allocate(words)
+        n_inputs = len(self._netlist.inputs)
+        mask = (1 << lanes) - 1
+        rows = b"".join(
+            (word & mask).to_bytes(words * 8, "little") for word in inputs[:n_inputs]
+        )
+        host = numpy.frombuffer(rows, dtype=numpy.uint64).reshape(n_inputs, words)
+        state.reshape(-1, words)[self._inputs] = cupy.asarray(host)
+        return self._run(words, lanes)
+
+    def simulate_counter(self, n_inputs: int, start: int, lanes: int) -> List[int]:
+        """Simulate the vectors 'start' to 'start + lanes - 1', generated on the GPU
+        (see 'BatchSimulator.simulate_counter()')."""
+        if start % _WORD_SIZE != 0:
+            return super().simulate_counter(n_inputs, start, lanes)
+        words = -(-lanes // _WORD_SIZE)
+        state = self._allocate(words)
+        n_inputs = len(self._netlist.inputs)
+        self._counter_inputs(
+            (_blocks(n_inputs * words),),
+            (_THREADS_PER_BLOCK,),
+            (
+                self._inputs,
+                numpy.int32(n_inputs),
+                numpy.uint64(start // _WORD_SIZE),
+                numpy.int32(words),
+                state,
+            ),
+        )
+        return self._run(words, lanes)
+
+    def _run(self, words: int, lanes: int) -> List[int]:
+        """Evaluate the gates on the state buffer, and download the outputs."""
+        state = self._state
+        if words >= _FUSED_MIN_WORDS:
+            self._nand_fused(
+                (_blocks(words),),
+                (_THREADS_PER_BLOCK,),
+                (
+                    self._in_a,
+                    self._in_b,
+                    self._out,
+                    numpy.int32(self._netlist.nands_count),
+                    numpy.int32(words),
+                    state,
+                ),
+            )
+        else:
+            levels = self._netlist.levels
+            for begin, end in zip(levels[:-1], levels[1:]):
+                self._nand_level(
+                    (_blocks((end - begin) * words),),
+                    (_THREADS_PER_BLOCK,),
+                    (
+                        self._in_a,
+                        self._in_b,
+                        self._out,
+                        numpy.int32(begin),
+                        numpy.int32(end - begin),
+                        numpy.int32(words),
+                        state,
+                    ),
+                )
+        self._was_simulated = True
+
+        outputs = cupy.asnumpy(state.reshape(-1, words)[self._outputs]).tobytes()
+        row_size = words * 8
+        mask = (1 << lanes) - 1
+        return [
+            int.from_bytes(outputs[start : start + row_size], "little") & mask
+            for start in range(0, len(outputs), row_size)
+        ]
+
+    def _simulate(self, circuit: Circuit) -> bool:
+        """Unused: the simulation is done by the GPU kernels."""
+        raise NotImplementedError("The GPU simulation is done by 'simulate()'.")
+
+    def _reset(self, circuit: Circuit):
+        """noop: only the inputs are set before simulating."""
+        pass
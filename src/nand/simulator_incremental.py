@@ -0,0 +1,127 @@
+import heapq
+from typing import List, Sequence
+
+from nand.circuit import Circuit
+from nand.flat_netlist import FlatNetlist, flatten
+from nand.simulator import SimulationResult, Simulator
+
+
+class SimulatorIncremental(Simulator):
+    """An event-driven simulator re-evaluating only what changed.
+
+    The state of the wires is kept between simulations. When an input changes, only
+    the gates reading it are scheduled, and a gate whose output changes schedules the
+    gates reading this output in turn, its fan-out. The cost of a step is then
+    proportional to the activity in the circuit, not to its size.
+
+    The gates are evaluated in the topological order of the flat netlist: the
+    scheduled gates are in a heap of their indices. So, a gate is only evaluated once
+    per step, after all the gates it depends on.
+
+    Attributes:
+        last_step_evaluations: The number of gates evaluated during the last step.
+    """
+
+    def __init__(self, circuit: Circuit):
+        super().__init__(circuit)
+
+        self._netlist: FlatNetlist = flatten(self._circuit)
+        self._in_a = list(self._netlist.in_a)
+        self._in_b = list(self._netlist.in_b)
+        self._out = list(self._netlist.out)
+
+        # The gates reading each wire.
+        self._fanout: List[List[int]] = [[] for _ in range(self._netlist.wires_count)]
+        for gate, (a, b) in enumerate(zip(self._in_a, self._in_b)):
+            self._fanout[a].append(gate)
+            if b != a:
+                self._fanout[b].append(gate)
+
+        self._scheduled: List[bool] = [False] * self._netlist.nands_count
+        self._queue: List[int] = []
+        self.last_step_evaluations = 0
+
+        # Start from a consistent state: all the inputs are off, and every gate is
+        # evaluated once.
+        self._state: List[bool] = [False] * self._netlist.wires_count
+        for gate in range(self._netlist.nands_count):
+            self._schedule(gate)
+        self.step()
+
+    @property
+    def netlist(self) -> FlatNetlist:
+        return self._netlist
+
+    def set_input(self, idx: int, value: bool):
+        """Set the 'idx'-th input of the circuit, and schedule the gates reading it if
+        it changed. Nothing is evaluated before the next 'step()'.
+        """
+        wire = self._netlist.inputs[idx]
+        value = bool(value)
+        if self._state[wire] == value:
+            return
+        self._state[wire] = value
+        for gate in self._fanout[wire]:
+            self._schedule(gate)
+
+    def step(self) -> SimulationResult:
+        """Propagate the changes of the inputs through the circuit.
+
+        Returns:
+            The output values of the circuit.
+        """
+        state = self._state
+        queue = self._queue
+        evaluations = 0
+        while queue:
+            gate = heapq.heappop(queue)
+            self._scheduled[gate] = False
+            evaluations += 1
+
+            out = self._out[gate]
+            value = not (state[self._in_a[gate]] and state[self._in_b[gate]])
+            if state[out] != value:
+                state[out] = value
+                for next_gate in self._fanout[out]:
+                    self._schedule(next_gate)
+
+        self.last_step_evaluations = evaluations
+        self._was_simulated = True
+        return [state[idx] for idx in self._netlist.outputs]
+
+    def simulate(self, inputs: Sequence[bool]) -> SimulationResult:
+        """Simulate the circuit with the given inputs, re-evaluating only the gates
+        affected by the inputs that changed since the last simulation.
+
+        Args:
+            inputs: The input values to simulate.
+
+        Returns:
+            The output values of the circuit.
+        """
+        for idx, input in zip(range(len(self._netlist.inputs)), inputs):
+            self.set_input(idx, input)
+        return self.step()
+
+    def _schedule(self, gate: int):
+        if not self._scheduled[gate]:
+            self._scheduled[gate] = True
+            heapq.heappush(self._queue, gate)
+
+    def _simulate(self, circuit: Circuit) -> bool:
+        """Unused: the simulation is done by 'step()'."""
+        raise NotImplementedError("The incremental simulation is done by 'step()'.")
+
+    def _reset(self, circuit: Circuit):
+        """noop: the state is kept between simulations."""
+        pass
+
+    def __str__(self):
+        """Return a simple string representation of the simulator, using the state
+        buffer as the wires of the circuit are not used for simulation."""
+        ins = "".join("1" if self._state[idx] else "0" for idx in self._netlist.inputs)
+        outs = "".join(
+            "1" if self._state[idx] else "0" for idx in self._netlist.outputs
+        )
+        simulated = "simulated" if self._was_simulated else "not simulated"
+        return f"{self._circuit.identifier} {simulated}: {ins} -> {outs}"
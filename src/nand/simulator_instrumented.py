@@ -0,0 +1,145 @@
+from dataclasses import dataclass
+from time import perf_counter
+from typing import Dict, List, Sequence, Tuple
+
+from nand.circuit import Circuit, CircuitId
+from nand.optimization_level import OptimizationLevel
+from nand.simulator import SimulationResult, Simulator
+from nand.simulator_debug import SimulatorDebug
+from nand.simulator_fast import SimulatorFast
+
+
+@dataclass
+class CircuitStats:
+    """The statistics of the simulations of one circuit, all its instances together.
+
+    Attributes:
+        evaluations: The number of successful simulations of an instance.
+        failures: The number of simulations of an instance which could not complete.
+                  Only the DEBUG simulator fails, on incorrect circuits: see
+                  'SimulatorDebug.unresolved'.
+        total_time: The time spent simulating the instances, sub-components included,
+                    in seconds.
+        self_time: The time spent in the instances themselves, sub-components
+                   excluded, in seconds.
+    """
+
+    evaluations: int = 0
+    failures: int = 0
+    total_time: float = 0.0
+    self_time: float = 0.0
+
+
+class SimulationStats:
+    """The statistics of the simulations of an instrumented simulator.
+
+    Attributes:
+        runs: The number of simulated vectors.
+        nand_evaluations: The number of NAND gates evaluated.
+        failures: The number of simulations which could not complete, all the
+                  circuits together.
+        circuits: The statistics of each circuit, by identifier.
+    """
+
+    def __init__(self):
+        self.runs = 0
+        self.nand_evaluations = 0
+        self.failures = 0
+        self.circuits: Dict[CircuitId, CircuitStats] = {}
+
+    def hot_spots(self) -> List[Tuple[CircuitId, CircuitStats]]:
+        """The circuits, from the most to the least time spent in themselves."""
+        return sorted(self.circuits.items(), key=lambda item: -item[1].self_time)
+
+    def report(self, limit: int = 10) -> str:
+        """A table of the 'limit' hottest circuits."""
+        lines = [
+            f"{self.runs} runs, {self.nand_evaluations} NAND evaluations, "
+            f"{self.failures} failures",
+            f"{'circuit':<24} {'evaluations':>11} {'failures':>8} "
+            f"{'self (ms)':>10} {'total (ms)':>10}",
+        ]
+        for identifier, stats in self.hot_spots()[:limit]:
+            lines.append(
+                f"{str(identifier):<24} {stats.evaluations:>11} {stats.failures:>8} "
+                f"{stats.self_time * 1e3:>10.2f} {stats.total_time * 1e3:>10.2f}"
+            )
+        return "\n".join(lines)
+
+
+class InstrumentedSimulation(Simulator):
+    """A mixin recording the statistics of the recursive simulators.
+
+    Each call to '_simulate()' is counted and timed, and aggregated by the identifier
+    of the circuit. The mixin is used instead of the simulator it instruments, so the
+    simulators themselves don't pay for any check when not instrumented:
+
+        class SimulatorFastInstrumented(InstrumentedSimulation, SimulatorFast): ...
+
+    Attributes:
+        stats: The statistics of all the simulations since the creation of the
+               simulator, or the last 'reset_stats()'.
+    """
+
+    def __init__(self, circuit: Circuit):
+        super().__init__(circuit)
+        self.stats = SimulationStats()
+        # The time spent in the sub-components of each circuit being simulated.
+        self._children_times: List[float] = []
+
+    def reset_stats(self):
+        self.stats = SimulationStats()
+
+    def simulate(self, inputs: Sequence[bool]) -> SimulationResult:
+        self.stats.runs += 1
+        return super().simulate(inputs)
+
+    def _simulate(self, circuit: Circuit) -> bool:
+        children_times = self._children_times
+        children_times.append(0.0)
+        start = perf_counter()
+        result = super()._simulate(circuit)
+        elapsed = perf_counter() - start
+        children_time = children_times.pop()
+        if len(children_times) != 0:
+            children_times[-1] += elapsed
+
+        stats = self.stats
+        circuit_stats = stats.circuits.get(circuit.identifier)
+        if circuit_stats is None:
+            circuit_stats = stats.circuits[circuit.identifier] = CircuitStats()
+        if result:
+            circuit_stats.evaluations += 1
+            if circuit.identifier == 0:
+                stats.nand_evaluations += 1
+        else:
+            circuit_stats.failures += 1
+            stats.failures += 1
+        circuit_stats.total_time += elapsed
+        circuit_stats.self_time += elapsed - children_time
+        return result
+
+
+class SimulatorDebugInstrumented(InstrumentedSimulation, SimulatorDebug):
+    """'SimulatorDebug', with its statistics."""
+
+
+class SimulatorFastInstrumented(InstrumentedSimulation, SimulatorFast):
+    """'SimulatorFast', with its statistics."""
+
+
+def build_instrumented_simulator(
+    circuit: Circuit, level: OptimizationLevel
+) -> InstrumentedSimulation:
+    """Build an instrumented simulator according to the optimization level.
+
+    Only the recursive simulators, DEBUG and FAST, have statistics per circuit: the
+    other ones simulate a flat netlist, where the circuits don't exist anymore.
+    """
+    match level:
+        case OptimizationLevel.DEBUG:
+            return SimulatorDebugInstrumented(circuit)
+        case OptimizationLevel.FAST:
+            return SimulatorFastInstrumented(circuit)
+        case _:
+            raise ValueError(f"The optimization level {level} can't be instrumented.")
@@ -0,0 +1,237 @@
+from dataclasses import dataclass
+from typing import Dict, List, Optional, Sequence, Tuple
+from weakref import WeakKeyDictionary
+
+from nand.circuit import Circuit, CircuitId
+from nand.circuit_optimizer import optimize
+from nand.circuits_library import CircuitLibrary
+from nand.simulator import SimulationResult, Simulator
+from nand.simulator_bit_parallel import (
+    SimulatorBitParallel,
+    counter_inputs,
+    unpack_lanes,
+)
+from nand.wire import Wire
+
+
+@dataclass(frozen=True)
+class LookupTable:
+    """The precomputed truth table of a circuit.
+
+    The index of a row is the integer formed by the inputs of the circuit, the i-th
+    input being the i-th bit. A row is the tuple of the outputs for these inputs.
+    """
+
+    n_inputs: int
+    rows: Tuple[Tuple[bool, ...], ...]
+
+    @classmethod
+    def from_circuit(cls, circuit: Circuit) -> "LookupTable":
+        """Compute the table of a circuit, in a single bit-parallel pass."""
+        n_inputs = len(circuit.inputs)
+        lanes = 1 << n_inputs
+        simulator = SimulatorBitParallel(circuit, lanes)
+        outputs = simulator.simulate_words(counter_inputs(n_inputs, 0, lanes), lanes)
+        return cls(n_inputs, tuple(tuple(row) for row in unpack_lanes(outputs, lanes)))
+
+
+# The NAND gate is known, and its instances often have both inputs on the same wire.
+NAND_TABLE = LookupTable(2, ((True,), (True,), (True,), (False,)))
+
+type LookupTables = Dict[CircuitId, LookupTable]
+
+# The tables computed from the circuits of a library, shared by all the simulators
+# built with this library. A library can only grow, so its tables never become stale.
+_libraries_tables: "WeakKeyDictionary[CircuitLibrary, LookupTables]" = (
+    WeakKeyDictionary()
+)
+
+
+def library_tables(library: CircuitLibrary) -> LookupTables:
+    """Get the cache of the tables of a library."""
+    return _libraries_tables.setdefault(library, {})
+
+
+# A table operation: the state index and the weight of each input, the state index
+# of each output, and the rows of the table.
+type _TableOp = Tuple[
+    Tuple[Tuple[int, int], ...], Tuple[int, ...], Tuple[Tuple[bool, ...], ...]
+]
+
+
+class SimulatorLookupTable(Simulator):
+    """A simulator replacing the small sub-circuits by precomputed lookup tables.
+
+    The circuit is flattened like for the compiled simulator, except that any
+    component with at most 'max_inputs' inputs isn't expanded into its NAND gates: it
+    becomes a single lookup into the truth table of its circuit. The largest such
+    components are used, e.g. a 2-bits adder instead of its full adders.
+
+    The tables are keyed by the identifier of the circuits, so all the instances of a
+    circuit share the same table. They are computed from the circuits of 'library' if
+    given, and then cached for all the simulators built from this library. Otherwise,
+    they are computed from the first instance found in the circuit.
+
+    Like the fast simulator, it assumes the circuit is correctly defined.
+    """
+
+    DEFAULT_MAX_INPUTS = 8
+
+    def __init__(
+        self,
+        circuit: Circuit,
+        library: Optional[CircuitLibrary] = None,
+        max_inputs: int = DEFAULT_MAX_INPUTS,
+    ):
+        super().__init__(circuit)
+        if max_inputs < 2:
+            raise ValueError(f"A table must have at least 2 inputs, not {max_inputs}.")
+        self._max_inputs = max_inputs
+        self._library = library
+        self._tables: LookupTables = (
+            library_tables(library) if library is not None else {}
+        )
+
+        self._orders = optimize(self._circuit)
+
+        self._wires_count = 0
+        self._inputs: List[int] = []
+        self._ops: List[_TableOp] = []
+        # Mapping between the id of the Wire objects and their index in the state.
+        indices: Dict[int, int] = {}
+
+        for wire in self._circuit.inputs.values():
+            indices[wire.id] = self._add_wire()
+            self._inputs.append(indices[wire.id])
+
+        self._compile_component(self._circuit, indices)
+
+        self._outputs = [
+            self._wire_index(wire, indices) for wire in self._circuit.outputs.values()
+        ]
+        self._state: List[bool] = [False] * self._wires_count
+
+    @property
+    def tables_count(self) -> int:
+        """The number of table lookups of a simulation."""
+        return len(self._ops)
+
+    def simulate(self, inputs: Sequence[bool]) -> SimulationResult:
+        """Simulate the circuit with the given inputs.
+
+        Args:
+            inputs: The input values to simulate.
+
+        Returns:
+            The output values of the circuit.
+        """
+        state = self._state
+        for idx, input in zip(self._inputs, inputs):
+            state[idx] = bool(input)
+
+        self._simulate(self._circuit)
+        self._was_simulated = True
+
+        return [state[idx] for idx in self._outputs]
+
+    def _simulate(self, circuit: Circuit) -> bool:
+        """Evaluate the table lookups in order.
+
+        Returns:
+            bool: systematically True: there's no check of simulation failure.
+        """
+        state = self._state
+        for ins, outs, rows in self._ops:
+            row_idx = 0
+            for idx, weight in ins:
+                if state[idx]:
+                    row_idx |= weight
+            for idx, value in zip(outs, rows[row_idx]):
+                state[idx] = value
+        return True
+
+    def _reset(self, circuit: Circuit):
+        """noop: only the inputs are set before simulating."""
+        pass
+
+    def _add_wire(self) -> int:
+        self._wires_count += 1
+        return self._wires_count - 1
+
+    def _compile_component(self, component: Circuit, indices: Dict[int, int]):
+        """Recursively emit the table lookups of a component.
+
+        A component is a lookup if it's small enough and its table is known or can be
+        computed. Otherwise, its sub-components are compiled in turn, down to the
+        NAND gates that are always lookups.
+        """
+        n_inputs = len(component.inputs)
+        table = None
+        if component.identifier == 0 or n_inputs <= self._max_inputs:
+            table = self._get_table(component)
+
+        if table is None:
+            components = component.components
+            for key in self._orders[component.identifier].keys:
+                self._compile_component(components[key], indices)
+            return
+
+        ins = tuple(
+            (self._wire_index(wire, indices), 1 << bit)
+            for bit, wire in enumerate(component.inputs.values())
+        )
+        outs = []
+        for wire in component.outputs.values():
+            # An output can be directly connected to an input, or to another output.
+            if wire.id not in indices:
+                indices[wire.id] = self._add_wire()
+            outs.append(indices[wire.id])
+        self._ops.append((ins, tuple(outs), table.rows))
+
+    def _get_table(self, component: Circuit) -> Optional[LookupTable]:
+        """Get the table of a component, computing it if needed.
+
+        Returns:
+            The table, or None if it can't be computed from this component.
+        """
+        identifier = component.identifier
+        if identifier == 0:
+            return NAND_TABLE
+        if identifier in self._tables:
+            return self._tables[identifier]
+
+        if self._library is not None and self._library.has_circuit(identifier):
+            # Only read: computing a table doesn't modify the circuit.
+            source = self._library.library[identifier]
+        elif self._has_distinct_inputs(component):
+            source = component
+        else:
+            # Several inputs of this instance are the same wire, so which internal
+            # port belongs to which input is lost. Another instance may do.
+            return None
+
+        self._tables[identifier] = LookupTable.from_circuit(source)
+        return self._tables[identifier]
+
+    @staticmethod
+    def _has_distinct_inputs(component: Circuit) -> bool:
+        ids = {wire.id for wire in component.inputs.values()}
+        return len(ids) == len(component.inputs)
+
+    @staticmethod
+    def _wire_index(wire: Wire, indices: Dict[int, int]) -> int:
+        """Get the index of an already driven wire."""
+        if wire.id not in indices:
+            raise ValueError(
+                f"Wire {wire.id} is read before being driven: "
+                f"the circuit has a missing or cyclic connection."
+            )
+        return indices[wire.id]
+
+    def __str__(self):
+        """Return a simple string representation of the simulator, using the state
+        buffer as the wires of the circuit are not used for simulation."""
+        ins = "".join("1" if self._state[idx] else "0" for idx in self._inputs)
+        outs = "".join("1" if self._state[idx] else "0" for idx in self._outputs)
+        simulated = "simulated" if self._was_simulated else "not simulated"
+        return f"{self._circuit.identifier} {simulated}: {ins} -> {outs}"
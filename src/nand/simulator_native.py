@@ -0,0 +1,145 @@
+from typing import List, Optional, Sequence
+
+from nand.circuit import Circuit
+from nand.flat_netlist import FlatNetlist, flatten, levelize
+from nand.simulator import SimulationResult, Simulator
+from nand.simulator_bit_parallel import BatchSimulator
+
+# The native extension is optional: it's only available if it was compiled when
+# installing the package.
+try:
+    from nand import _native  # type: ignore[attr-defined]
+except ImportError:
+    _native = None
+
+
+# The native batched kernel works on rows of 64 bits words.
+_WORD_SIZE = 64
+# The widest SIMD register holds 8 words (AVX-512), the rows are padded to it.
+_ROW_ALIGNMENT = 8
+
+
+def is_native_available() -> bool:
+    """Check if the native extension 'nand._native' was built."""
+    return _native is not None
+
+
+def native_simd_level() -> str:
+    """The instruction set selected at runtime for the native batched kernel:
+    'avx512', 'avx2', or 'scalar'.
+    """
+    if _native is None:
+        raise RuntimeError("The native extension 'nand._native' is not available.")
+    return _native.simd_level()
+
+
+class SimulatorNative(Simulator, BatchSimulator):
+    """A simulator running the flat netlist of the circuit in native code.
+
+    The circuit is compiled into a levelized flat netlist, and handed to the native
+    kernel. A simulation is then a single native loop over the NAND gates, without
+    any Python code per gate.
+
+    The batched simulation evaluates the input vectors 64 bits words at a time,
+    using SIMD instructions (AVX2 or AVX-512) when the CPU supports them.
+
+    It assumes the circuit is correctly defined, but a missing connection is
+    detected during compilation.
+
+    Like for the compiled simulator, an already flat netlist can be given.
+    """
+
+    DEFAULT_LANES = 8192
+
+    def __init__(
+        self,
+        circuit: Circuit,
+        lanes: int = DEFAULT_LANES,
+        netlist: Optional[FlatNetlist] = None,
+    ):
+        if _native is None:
+            raise RuntimeError(
+                "The native extension 'nand._native' is not available: "
+                "the package must be installed with a C++ compiler."
+            )
+        super().__init__(circuit)
+        if lanes < 1:
+            raise ValueError(f"The number of lanes must be positive, not {lanes}.")
+        self.lanes = lanes
+
+        # The levelization makes the batched kernel stream through the state buffer.
+        if netlist is None:
+            netlist = flatten(self._circuit)
+        self._netlist: FlatNetlist = netlist if netlist.levels else levelize(netlist)
+        self._kernel = self._build_kernel()
+
+    def _build_kernel(self):
+        """Hand the flat netlist to the native kernel."""
+        return _native.Kernel(
+            self._netlist.wires_count,
+            self._netlist.inputs,
+            self._netlist.outputs,
+            self._netlist.in_a,
+            self._netlist.in_b,
+            self._netlist.out,
+        )
+
+    def __getstate__(self):
+        """The native kernel can't be pickled, but it can be rebuilt from the
+        netlist, for example to send the simulator to another process."""
+        state = self.__dict__.copy()
+        del state["_kernel"]
+        return state
+
+    def __setstate__(self, state):
+        self.__dict__.update(state)
+        self._kernel = self._build_kernel()
+
+    @property
+    def netlist(self) -> FlatNetlist:
+        return self._netlist
+
+    def simulate(self, inputs: Sequence[bool]) -> SimulationResult:
+        """Simulate the circuit with the given inputs.
+
+        Args:
+            inputs: The input values to simulate.
+
+        Returns:
+            The output values of the circuit.
+        """
+        self._was_simulated = True
+        return self._kernel.simulate(inputs)
+
+    def simulate_words(self, inputs: Sequence[int], lanes: int) -> List[int]:
+        """Simulate the circuit with the given packed inputs (see 'BatchSimulator')."""
+        words = -(-lanes // _WORD_SIZE)
+        words += -words % _ROW_ALIGNMENT
+        row_size = words * _WORD_SIZE // 8
+        mask = (1 << lanes) - 1
+
+        rows = b"".join((word & mask).to_bytes(row_size, "little") for word in inputs)
+        outputs = self._kernel.simulate_words(rows, words)
+        self._was_simulated = True
+
+        return [
+            int.from_bytes(outputs[start : start + row_size], "little") & mask
+            for start in range(0, len(outputs), row_size)
+        ]
+
+    def _simulate(self, circuit: Circuit) -> bool:
+        """Unused: the simulation is done by the native kernel."""
+        raise NotImplementedError("The native simulation is done by 'simulate()'.")
+
+    def _reset(self, circuit: Circuit):
+        """noop: only the inputs are set before simulating."""
+        pass
+
+    def __str__(self):
+        """Return a simple string representation of the simulator.
+
+        The wires of the circuit are not used for simulation, so only the status is
+        shown.
+        """
+        simulated = "simulated" if self._was_simulated else "not simulated"
+        return f"{self._circuit.identifier} {simulated} (native)"
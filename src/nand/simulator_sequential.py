@@ -0,0 +1,265 @@
+from dataclasses import dataclass
+from typing import Dict, List, Optional, Sequence, Tuple
+
+from nand.circuit import Circuit, InputId
+from nand.flat_netlist import FlatNetlist, levelize
+from nand.optimization_level import OptimizationLevel
+from nand.simulator import SimulationResult, Simulator
+from nand.simulator_builder import build_netlist_simulator
+
+
+@dataclass
+class SequentialNetlist:
+    """A circuit with feedback loops, lowered to a combinational netlist.
+
+    Each loop is broken at a feedback wire: the gates closing the loop read a state
+    wire instead, holding the value of the feedback wire at the previous pass. The
+    state wires are extra inputs of the combinational netlist, and the feedback wires
+    extra outputs, so it can be simulated by any flat simulator.
+
+    Attributes:
+        combinational: The levelized netlist of the circuit without its loops. Its
+                       inputs are the ones of the circuit, then the state wires. Its
+                       outputs are the ones of the circuit, then the feedback wires, in
+                       the same order as the state wires.
+        inputs_count: The number of inputs of the circuit.
+        outputs_count: The number of outputs of the circuit.
+    """
+
+    combinational: FlatNetlist
+    inputs_count: int
+    outputs_count: int
+
+    @property
+    def states_count(self) -> int:
+        return len(self.combinational.inputs) - self.inputs_count
+
+
+def flatten_sequential(circuit: Circuit) -> SequentialNetlist:
+    """Lower a circuit, possibly with feedback loops, into a combinational netlist.
+
+    Unlike 'flatten()', the components aren't sorted: they don't need to be in a
+    topological order, and the circuit isn't modified. The NAND gates are walked
+    depth-first from their inputs, in the order of the circuit: an input whose driver
+    is still being walked closes a loop, and is read from a state wire.
+
+    Raises:
+        ValueError: If a wire is driven by nothing, meaning the circuit has a missing
+        connection.
+    """
+    nands: List[Tuple[int, int, int]] = []
+    _collect_nands(circuit, nands)
+    inputs = {wire.id: idx for idx, wire in enumerate(circuit.inputs.values())}
+    drivers = {out: gate for gate, (_, _, out) in enumerate(nands)}
+    read_wires = {wire_id for a, b, _ in nands for wire_id in (a, b)}
+    read_wires.update(wire.id for wire in circuit.outputs.values())
+    if any(w not in inputs and w not in drivers for w in read_wires):
+        raise ValueError(
+            f"A wire of the circuit {circuit.identifier} is driven by nothing."
+        )
+
+    netlist = FlatNetlist()
+    netlist.inputs = [netlist.add_wire() for _ in inputs]
+    signals: Dict[int, int] = {
+        wire_id: netlist.inputs[idx] for wire_id, idx in inputs.items()
+    }
+    # The state wire of each feedback wire, by the identifier of the feedback wire.
+    states: Dict[int, int] = {}
+    # 0: not walked, 1: being walked, 2: emitted.
+    marks = [0] * len(nands)
+
+    def read(wire_id: int) -> int:
+        signal = signals.get(wire_id)
+        if signal is not None:
+            return signal
+        if wire_id not in states:
+            states[wire_id] = netlist.add_wire()
+        return states[wire_id]
+
+    for root in range(len(nands)):
+        if marks[root] != 0:
+            continue
+        marks[root] = 1
+        # Each entry is a gate, and the number of its inputs already walked.
+        stack = [(root, 0)]
+        while len(stack) != 0:
+            gate, walked = stack.pop()
+            if walked < 2:
+                stack.append((gate, walked + 1))
+                driver = drivers.get(nands[gate][walked])
+                if driver is not None and marks[driver] == 0:
+                    marks[driver] = 1
+                    stack.append((driver, 0))
+                continue
+            a, b, out = nands[gate]
+            signals[out] = netlist.add_nand(read(a), read(b))
+            marks[gate] = 2
+
+    state_wires = list(states.values())
+    netlist.inputs += state_wires
+    netlist.outputs = [signals[wire.id] for wire in circuit.outputs.values()]
+    netlist.outputs += [signals[wire_id] for wire_id in states]
+    # The state wires were allocated among the outputs of the gates: renumbered by
+    # the levelization, they follow the inputs.
+    return SequentialNetlist(levelize(netlist), len(circuit.inputs), len(circuit.outputs))
+
+
+def _collect_nands(circuit: Circuit, nands: List[Tuple[int, int, int]]):
+    """List the NAND gates of a circuit, as the identifiers of their wires."""
+    if circuit.identifier == 0:
+        a, b = circuit.inputs.values()
+        nands.append((a.id, b.id, next(iter(circuit.outputs.values())).id))
+        return
+    for component in circuit.components.values():
+        _collect_nands(component, nands)
+
+
+class SimulatorSequential(Simulator):
+    """A cycle-based simulator of the circuits with feedback loops: latches,
+    flip-flops, registers, and the logic between them.
+
+    The simulated circuit keeps its state from one simulation to the next. A
+    simulation applies the inputs, and then repeats passes over the combinational
+    netlist until the circuit settles: a pass commits the values of the feedback
+    wires into the state wires, and the circuit is settled once a pass doesn't change
+    them anymore. Most circuits settle in two or three passes. A circuit which doesn't
+    settle, e.g. a ring oscillator, makes the simulation fail.
+
+    The passes are simulated by a flat simulator of the combinational netlist, so the
+    batched ones simulate as many independent copies of the circuit as there are
+    lanes, each one with its own state.
+
+    With a clock input, 'tick()' simulates a whole clock cycle, 0 then 1: the
+    flip-flops of 'nand.circuit_generators' are triggered by its rising edge.
+
+    The state is all 0 at the start, which isn't always a settled state: the value of
+    a memory is arbitrary until it's written, as in hardware.
+
+    Attributes:
+        netlist: The combinational netlist of the circuit.
+        clock: The index of the clock input, if any.
+        max_passes: The number of passes after which a circuit not settled is
+                    considered oscillating.
+        passes: The number of passes of the last simulation.
+    """
+
+    def __init__(
+        self,
+        circuit: Circuit,
+        level: OptimizationLevel = OptimizationLevel.COMPILED,
+        clock: Optional[InputId] = None,
+        max_passes: Optional[int] = None,
+    ):
+        super().__init__(circuit)
+        self.netlist = flatten_sequential(circuit)
+        self._kernel = build_netlist_simulator(
+            self.netlist.combinational, level, str(circuit.identifier)
+        )
+        self.clock: Optional[int] = None
+        if clock is not None:
+            if clock not in circuit.inputs:
+                raise ValueError(f"The circuit has no clock input {clock}.")
+            self.clock = list(circuit.inputs).index(clock)
+        # A settling change crosses at least one more loop at each pass.
+        self.max_passes = (
+            self.netlist.states_count + 2 if max_passes is None else max_passes
+        )
+        self.passes = 0
+        self.reset_state()
+
+    def reset_state(self):
+        """Reset the state wires to 0."""
+        self._state: List[bool] = [False] * self.netlist.states_count
+        self._state_words: List[int] = [0] * self.netlist.states_count
+
+    def simulate(self, inputs: Sequence[bool]) -> SimulationResult:
+        """Apply the inputs and settle the circuit.
+
+        Returns:
+            The outputs of the settled circuit, or False if it doesn't settle.
+        """
+        inputs = list(inputs[: self.netlist.inputs_count])
+        count = self.netlist.outputs_count
+        for passes in range(1, self.max_passes + 1):
+            outputs = self._kernel.simulate(inputs + self._state)
+            assert outputs is not False
+            state = list(outputs[count:])
+            if state == self._state:
+                self.passes = passes
+                self._was_simulated = True
+                return list(outputs[:count])
+            self._state = state
+        self.passes = self.max_passes
+        return False
+
+    def simulate_words(self, inputs: Sequence[int], lanes: int) -> List[int]:
+        """Apply packed inputs to independent copies of the circuit, one per lane, and
+        settle them (see 'BatchSimulator.simulate_words()').
+
+        Only the batched levels, BIT_PARALLEL and NATIVE, can simulate words.
+
+        Raises:
+            ValueError: If a copy of the circuit doesn't settle.
+        """
+        inputs = list(inputs[: self.netlist.inputs_count])
+        count = self.netlist.outputs_count
+        for passes in range(1, self.max_passes + 1):
+            outputs = self._kernel.simulate_words(inputs + self._state_words, lanes)
+            state = outputs[count:]
+            if state == self._state_words:
+                self.passes = passes
+                self._was_simulated = True
+                return outputs[:count]
+            self._state_words = state
+        self.passes = self.max_passes
+        raise ValueError(
+            f"The circuit {self._circuit.identifier} doesn't settle in "
+            f"{self.max_passes} passes."
+        )
+
+    def tick(self, inputs: Sequence[bool]) -> SimulationResult:
+        """Simulate a clock cycle: the clock at 0, and then at 1.
+
+        Args:
+            inputs: The inputs other than the clock, in order.
+
+        Returns:
+            The outputs after the rising edge of the clock, or False if the circuit
+            doesn't settle.
+        """
+        clock = self._clock_index()
+        inputs = list(inputs)
+        if self.simulate(inputs[:clock] + [False] + inputs[clock:]) is False:
+            return False
+        return self.simulate(inputs[:clock] + [True] + inputs[clock:])
+
+    def tick_words(self, inputs: Sequence[int], lanes: int) -> List[int]:
+        """Simulate a clock cycle of each copy of the circuit (see 'tick()' and
+        'simulate_words()').
+        """
+        clock = self._clock_index()
+        inputs = list(inputs)
+        self.simulate_words(inputs[:clock] + [0] + inputs[clock:], lanes)
+        return self.simulate_words(
+            inputs[:clock] + [(1 << lanes) - 1] + inputs[clock:], lanes
+        )
+
+    def _clock_index(self) -> int:
+        if self.clock is None:
+            raise ValueError("The simulator has no clock input.")
+        return self.clock
+
+    def _simulate(self, circuit: Circuit) -> bool:
+        """Unused: the simulation is done by the kernel, pass after pass."""
+        raise NotImplementedError("The simulation is done by the kernel.")
+
+    def _reset(self, circuit: Circuit):
+        """noop: the state is kept from one simulation to the next."""
+        pass
+
+    def __str__(self):
+        """Return a simple string representation of the simulator, with the state
+        wires as the wires of the circuit are not used for simulation."""
+        state = "".join("1" if value else "0" for value in self._state)
+        simulated = "simulated" if self._was_simulated else "not simulated"
+        return f"{self._circuit.identifier} {simulated}: state {state}"
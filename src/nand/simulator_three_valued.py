@@ -0,0 +1,126 @@
+from typing import List, Optional, Sequence, Tuple
+
+from nand.circuit import Circuit
+from nand.flat_netlist import FlatNetlist
+from nand.simulator_bit_parallel import SimulatorBitParallel, pack_lanes, unpack_lanes
+from nand.wire import WireState
+from nand.wire_extended_state import WireExtendedState
+
+# For each wire, the word of its known lanes, and the word of its values. The value
+# of an unknown lane is always 0.
+type Planes = Tuple[List[int], List[int]]
+type StatesBatch = List[List[WireExtendedState]]
+
+
+class SimulatorThreeValued(SimulatorBitParallel):
+    """A bit-parallel simulator of partially specified inputs.
+
+    Each wire is two words, or "bit-planes": the lanes where its state is known, and
+    its value in these lanes. An unknown lane is the UNKNOWN state of 'WireDebug', so
+    the inputs left undriven can be simulated for many vectors at once, instead of one
+    vector at a time with 'SimulatorDebug'.
+
+    The NAND gates follow the three-valued logic: the output is known to be 1 as soon
+    as an input is known to be 0, whatever the other one is, and known to be 0 if both
+    inputs are known to be 1. In the strict mode, the output is unknown as soon as an
+    input is: as 'SimulatorDebug', which doesn't simulate a gate before all its inputs
+    are known. The difference is still that 'SimulatorDebug' does it for each
+    component, while this simulator does it for each gate: an output not depending on
+    an unknown input is known.
+
+    The binary simulations, 'simulate()' and 'simulate_words()', are the ones of
+    'SimulatorBitParallel'.
+
+    Attributes:
+        strict: Whether an unknown input makes the output of a gate unknown.
+    """
+
+    def __init__(
+        self,
+        circuit: Circuit,
+        lanes: int = SimulatorBitParallel.DEFAULT_LANES,
+        netlist: Optional[FlatNetlist] = None,
+        strict: bool = False,
+    ):
+        super().__init__(circuit, lanes, netlist)
+        self.strict = strict
+        self._known: List[int] = [0] * self._netlist.wires_count
+
+    def simulate_planes(
+        self, values: Sequence[int], known: Sequence[int], lanes: int
+    ) -> Planes:
+        """Simulate the circuit with the given packed inputs.
+
+        Args:
+            values: For each input of the circuit, a word whose k-th bit is the value
+            of this input for the k-th input vector. It's ignored where the input is
+            unknown.
+            known: For each input of the circuit, a word whose k-th bit is set if this
+            input is known for the k-th input vector.
+            lanes: The number of input vectors packed in the words.
+
+        Returns:
+            For each output of the circuit, the words of its known lanes and of its
+            values, as for the inputs.
+        """
+        mask = (1 << lanes) - 1
+        words = self._words
+        known_words = self._known
+        for idx, value, is_known in zip(self._netlist.inputs, values, known):
+            known_words[idx] = is_known & mask
+            words[idx] = value & is_known & mask
+
+        # The values are 0 in the unknown lanes, so 'known ^ value' are the lanes
+        # known to be 0, and 'value' the lanes known to be 1.
+        if self.strict:
+            for a, b, out in self._nands:
+                known_out = known_words[a] & known_words[b]
+                known_words[out] = known_out
+                words[out] = known_out ^ (words[a] & words[b])
+        else:
+            for a, b, out in self._nands:
+                zeros = (known_words[a] ^ words[a]) | (known_words[b] ^ words[b])
+                known_words[out] = zeros | (words[a] & words[b])
+                words[out] = zeros
+
+        self._was_simulated = True
+
+        outputs = self._netlist.outputs
+        return [words[idx] for idx in outputs], [known_words[idx] for idx in outputs]
+
+    def simulate_states(self, inputs: Sequence[Sequence[WireState]]) -> StatesBatch:
+        """Simulate the circuit for a batch of partially specified input vectors.
+
+        Args:
+            inputs: A matrix of inputs: one row per input vector, one column per input
+            of the circuit. A state is a boolean, or a 'WireExtendedState'.
+
+        Returns:
+            A matrix of outputs: one row per input vector, one column per output of the
+            circuit.
+        """
+        unknown = WireExtendedState.UNKNOWN
+        results: StatesBatch = []
+        for start in range(0, len(inputs), self.lanes):
+            chunk = inputs[start : start + self.lanes]
+            known = pack_lanes([[s is not unknown for s in row] for row in chunk])
+            values = pack_lanes([[_is_on(s) for s in row] for row in chunk])
+            values, known = self.simulate_planes(values, known, len(chunk))
+            for value_row, known_row in zip(
+                unpack_lanes(values, len(chunk)), unpack_lanes(known, len(chunk))
+            ):
+                results.append(
+                    [
+                        _to_state(value) if is_known else unknown
+                        for value, is_known in zip(value_row, known_row)
+                    ]
+                )
+        return results
+
+
+def _is_on(state: WireState) -> bool:
+    return state is True or state is WireExtendedState.ON
+
+
+def _to_state(value: bool) -> WireExtendedState:
+    return WireExtendedState.ON if value else WireExtendedState.OFF
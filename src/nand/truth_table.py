@@ -0,0 +1,126 @@
+from collections import deque
+from concurrent.futures import Future, ProcessPoolExecutor
+from copy import deepcopy
+from dataclasses import dataclass
+from typing import Deque, Iterator, List, Optional, Tuple
+
+from nand.circuit import Circuit
+from nand.optimization_level import OptimizationLevel
+from nand.simulator_bit_parallel import BatchSimulator, unpack_lanes
+from nand.simulator_builder import build_simulator
+from nand.simulator_native import is_native_available
+
+
+@dataclass
+class TruthTableChunk:
+    """A contiguous range of the truth table of a circuit.
+
+    The input vectors are numbered by the integer they form: the i-th input of the
+    circuit is the i-th bit of the vector index. The outputs are packed: the k-th bit
+    of the j-th word is the j-th output of the vector 'start + k'.
+
+    Attributes:
+        start: The index of the first input vector of the chunk.
+        lanes: The number of input vectors in the chunk.
+        outputs: One packed word per output of the circuit.
+    """
+
+    start: int
+    lanes: int
+    outputs: List[int]
+
+    def rows(self) -> Iterator[Tuple[int, List[bool]]]:
+        """Unpack the chunk into (vector index, outputs) pairs."""
+        for k, row in enumerate(unpack_lanes(self.outputs, self.lanes)):
+            yield self.start + k, row
+
+
+# The simulator of a worker process, built once by '_init_worker()'. Only used in the
+# processes of the pool.
+_worker_simulator: Optional[BatchSimulator] = None
+
+
+def _build_batch_simulator(
+    circuit: Circuit, level: OptimizationLevel
+) -> BatchSimulator:
+    simulator = build_simulator(circuit, level)
+    if not isinstance(simulator, BatchSimulator):
+        raise ValueError(f"The optimization level {level} can't simulate batches.")
+    return simulator
+
+
+def _init_worker(circuit: Circuit, level: OptimizationLevel):
+    global _worker_simulator
+    _worker_simulator = _build_batch_simulator(circuit, level)
+
+
+def _simulate_range(n_inputs: int, start: int, lanes: int) -> TruthTableChunk:
+    if _worker_simulator is None:
+        raise RuntimeError("The worker was not initialized.")
+    outputs = _worker_simulator.simulate_counter(n_inputs, start, lanes)
+    return TruthTableChunk(start, lanes, outputs)
+
+
+def default_batch_level() -> OptimizationLevel:
+    """The fastest available optimization level able to simulate batches."""
+    if is_native_available():
+        return OptimizationLevel.NATIVE
+    return OptimizationLevel.BIT_PARALLEL
+
+
+def exhaustive_truth_table(
+    circuit: Circuit,
+    workers: int = 1,
+    chunk_lanes: int = 1 << 16,
+    level: Optional[OptimizationLevel] = None,
+) -> Iterator[TruthTableChunk]:
+    """Compute the whole truth table of a circuit, streamed by chunks.
+
+    The 2^n input space is split into ranges of 'chunk_lanes' vectors. Each worker
+    builds its own batched simulator once, and then generates and simulates the
+    vectors of the ranges it is given. Only the packed outputs are sent back.
+
+    The chunks are yielded in order. Only a few ranges per worker are in flight at any
+    time, so the memory used doesn't depend on the size of the input space.
+
+    Args:
+        circuit: The circuit to simulate. It is not modified.
+        workers: The number of worker processes. With 1, everything is done in the
+        current process.
+        chunk_lanes: The number of vectors per range, rounded up to a power of two.
+        level: The optimization level of the batched simulators. By default, the
+        fastest available.
+
+    Returns:
+        An iterator of the chunks of the truth table, covering all the input vectors.
+    """
+    if workers < 1:
+        raise ValueError(f"The number of workers must be positive, not {workers}.")
+    if level is None:
+        level = default_batch_level()
+
+    n_inputs = len(circuit.inputs)
+    total = 1 << n_inputs
+    # A power of two, so that the ranges are aligned and the inputs are patterns.
+    lanes = min(total, 1 << max(0, chunk_lanes - 1).bit_length())
+    starts = range(0, total, lanes)
+
+    if workers == 1:
+        # The simulator optimizes its circuit in place: it gets a copy. It is local to
+        # this iterator, so that several truth tables can be consumed at once.
+        simulator = _build_batch_simulator(deepcopy(circuit), level)
+        for start in starts:
+            outputs = simulator.simulate_counter(n_inputs, start, lanes)
+            yield TruthTableChunk(start, lanes, outputs)
+        return
+
+    with ProcessPoolExecutor(
+        max_workers=workers, initializer=_init_worker, initargs=(circuit, level)
+    ) as executor:
+        in_flight: Deque[Future[TruthTableChunk]] = deque()
+        for start in starts:
+            in_flight.append(executor.submit(_simulate_range, n_inputs, start, lanes))
+            if len(in_flight) >= 2 * workers:
+                yield in_flight.popleft().result()
+        while in_flight:
+            yield in_flight.popleft().result()
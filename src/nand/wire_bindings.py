@@ -0,0 +1,94 @@
+from typing import TYPE_CHECKING, Dict, List, Set
+
+from nand.wire import Wire
+
+if TYPE_CHECKING:
+    from nand.circuit import Circuit
+
+
+class WireBindings:
+    """The wires replaced by the connections of a circuit, not yet propagated to the
+    hierarchy of its components.
+
+    A connection replaces the wire of a component input by the wire of its source.
+    Instead of updating all the references to the old wire in the component hierarchy
+    at each connection, the replacement is recorded in a union-find: a connection
+    is O(α(n)), and all the references are resolved by a single walk of the
+    hierarchy (see 'Circuit.deferred_wiring()').
+
+    The union-find replaces a wire everywhere, while a connection only replaces it in
+    the hierarchy of its target. Both are the same as long as the old wire is private
+    to this hierarchy: it is the case of the wires of a new component, not the case of
+    the wires already shared at the circuit level, the inputs of the circuit and the
+    outputs of its components. 'is_shared()' tells the circuit when a connection
+    must be propagated immediately.
+
+    Attributes:
+        parents: The parent of each replaced wire, by id. A wire without parent is
+                 the representative of its set: the wire all the others are replaced
+                 by.
+        shared: The ids of the wires shared at the circuit level.
+        targets: The components whose inputs were connected, by object id.
+    """
+
+    def __init__(self, circuit: "Circuit"):
+        self.parents: Dict[int, Wire] = {}
+        self.targets: Dict[int, "Circuit"] = {}
+        self.shared: Set[int] = {wire.id for wire in circuit.inputs.values()}
+        for component in circuit.components.values():
+            self.add_component(component)
+
+    def add_component(self, component: "Circuit"):
+        """Record the outputs of a new component as shared."""
+        self.shared.update(wire.id for wire in component.outputs.values())
+
+    def add_input(self, wire: Wire):
+        """Record a new input wire of the circuit as shared."""
+        self.shared.add(wire.id)
+
+    def is_shared(self, wire: Wire) -> bool:
+        return wire.id in self.shared
+
+    def find(self, wire: Wire) -> Wire:
+        """The wire replacing the given one, with path compression."""
+        root = wire
+        while root.id in self.parents:
+            root = self.parents[root.id]
+        while wire.id in self.parents and self.parents[wire.id] is not root:
+            next_wire = self.parents[wire.id]
+            self.parents[wire.id] = root
+            wire = next_wire
+        return root
+
+    def bind(self, target: "Circuit", old_wire: Wire, new_wire: Wire):
+        """Replace all the references to 'old_wire' by 'new_wire' in the hierarchy of
+        the target component."""
+        self.targets[id(target)] = target
+        old_root, new_root = self.find(old_wire), self.find(new_wire)
+        if old_root is not new_root:
+            self.parents[old_root.id] = new_root
+
+    def resolve(self):
+        """Replace the bound wires in the hierarchies of the targets.
+
+        As with 'Circuit._propagate_wire_update()', a sub-component is only visited
+        if one of the inputs of its parent was replaced: the walk is limited to the
+        components the old wires go through, each one being visited once.
+        """
+        visited: Set[int] = set()
+        stack: List["Circuit"] = list(self.targets.values())
+        while len(stack) != 0:
+            component = stack.pop()
+            for sub_component in component.components.values():
+                if id(sub_component) in visited:
+                    continue
+                inputs = sub_component.inputs
+                updates = {
+                    k: self.find(w) for k, w in inputs.items() if w.id in self.parents
+                }
+                if len(updates) != 0:
+                    inputs.update(updates)
+                    visited.add(id(sub_component))
+                    stack.append(sub_component)
+        self.parents.clear()
+        self.targets.clear()
@@ -1,3 +1,5 @@
+from typing import List
+
 from nand.wire_extended_state import WireExtendedState
 from nand.wire import Wire, WireState
 
@@ -8,22 +10,34 @@ class WireDebug(Wire):
     Its internal state can not only be ON or OFF, but also UNKNOWN.
     It's useful for debugging, as the unknown state during simulation indicates an error
     in the circuit definition, or in the simulation itself.
+
+    The state is stored in a buffer, by default its own. The wires of a circuit can
+    share a single buffer (see 'bind_state()'), to reset all of them at once.
     """
 
     def __init__(self):
         super().__init__()
-        self._state: WireExtendedState = WireExtendedState.UNKNOWN
+        self._states: List[WireExtendedState] = [WireExtendedState.UNKNOWN]
+        self._index = 0
+
+    def bind_state(self, states: List[WireExtendedState], index: int):
+        """Store the state at 'states[index]', starting from the current state."""
+        states[index] = self._states[self._index]
+        self._states = states
+        self._index = index
 
     @property
     def state(self) -> WireExtendedState:
-        return self._state
+        return self._states[self._index]
 
     @state.setter
     def state(self, value: WireState):
         if isinstance(value, WireExtendedState):
-            self._state = value
+            self._states[self._index] = value
         elif isinstance(value, bool):
-            self._state = WireExtendedState.ON if value else WireExtendedState.OFF
+            self._states[self._index] = (
+                WireExtendedState.ON if value else WireExtendedState.OFF
+            )
         else:
             raise TypeError(
                 f"Trying to set the value of a {type(self).__name__} to an "
@@ -32,8 +46,8 @@ class WireDebug(Wire):
 
     def __str__(self):
         """Returns the underlying state"""
-        return str(self._state)
+        return str(self.state)
 
     def __repr__(self):
         """Return the full definition of the Wire, including its id."""
-        return f"{type(self).__name__}(id={self.id}, state={repr(self._state)}"
+        return f"{type(self).__name__}(id={self.id}, state={repr(self.state)}"
@@ -0,0 +1,453 @@
+// Native simulation kernel of the flat netlists (see 'nand/flat_netlist.py').
+//
+// The Python side compiles a circuit into a flat netlist: NAND gates as a structure of
+// arrays of wire indices, in topological order. This module only runs the evaluation
+// loop over these arrays, without any Python object per gate or per wire.
+//
+// There are two kernels:
+// - A single vector one, with one byte of state per wire.
+// - A batched one, where each wire holds a row of 64 bits words, each bit being an
+//   independent input vector. The loop over the words of a gate uses explicit SIMD
+//   (AVX2 or AVX-512), selected at runtime with a plain C++ fallback.
+//
+// It uses the bare CPython API to avoid any build dependency.
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <vector>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define NAND_NATIVE_X86_DISPATCH 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+using Index = std::int32_t;
+using Word = std::uint64_t;
+
+// The batched kernel: for each gate, 'words' words are evaluated. The state buffer is
+// wire-major: the words of a wire are contiguous.
+using WordsKernel = void (*)(Word *state, const Index *in_a, const Index *in_b,
+                             const Index *out, std::size_t gates, std::size_t words);
+
+void nand_words_scalar(Word *state, const Index *in_a, const Index *in_b,
+                       const Index *out, std::size_t gates, std::size_t words) {
+    for (std::size_t i = 0; i < gates; ++i) {
+        const Word *a = state + static_cast<std::size_t>(in_a[i]) * words;
+        const Word *b = state + static_cast<std::size_t>(in_b[i]) * words;
+        Word *o = state + static_cast<std::size_t>(out[i]) * words;
+        for (std::size_t w = 0; w < words; ++w) {
+            o[w] = ~(a[w] & b[w]);
+        }
+    }
+}
+
+#ifdef NAND_NATIVE_X86_DISPATCH
+__attribute__((target("avx2"))) void
+nand_words_avx2(Word *state, const Index *in_a, const Index *in_b, const Index *out,
+                std::size_t gates, std::size_t words) {
+    const __m256i ones = _mm256_set1_epi64x(-1);
+    for (std::size_t i = 0; i < gates; ++i) {
+        const Word *a = state + static_cast<std::size_t>(in_a[i]) * words;
+        const Word *b = state + static_cast<std::size_t>(in_b[i]) * words;
+        Word *o = state + static_cast<std::size_t>(out[i]) * words;
+        std::size_t w = 0;
+        for (; w + 4 <= words; w += 4) {
+            const __m256i va =
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + w));
+            const __m256i vb =
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + w));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(o + w),
+                                _mm256_xor_si256(_mm256_and_si256(va, vb), ones));
+        }
+        for (; w < words; ++w) {
+            o[w] = ~(a[w] & b[w]);
+        }
+    }
+}
+
+__attribute__((target("avx512f"))) void
+nand_words_avx512(Word *state, const Index *in_a, const Index *in_b, const Index *out,
+                  std::size_t gates, std::size_t words) {
+    for (std::size_t i = 0; i < gates; ++i) {
+        const Word *a = state + static_cast<std::size_t>(in_a[i]) * words;
+        const Word *b = state + static_cast<std::size_t>(in_b[i]) * words;
+        Word *o = state + static_cast<std::size_t>(out[i]) * words;
+        std::size_t w = 0;
+        for (; w + 8 <= words; w += 8) {
+            const __m512i va = _mm512_loadu_si512(a + w);
+            const __m512i vb = _mm512_loadu_si512(b + w);
+            // 0x3F is the truth table of NAND(a, b), the third operand is ignored.
+            _mm512_storeu_si512(o + w, _mm512_ternarylogic_epi64(va, vb, va, 0x3F));
+        }
+        for (; w < words; ++w) {
+            o[w] = ~(a[w] & b[w]);
+        }
+    }
+}
+#endif
+
+struct WordsKernelChoice {
+    WordsKernel kernel;
+    const char *name;
+};
+
+// Select the widest SIMD instruction set supported by the CPU.
+// The environment variable NAND_NATIVE_SIMD ("scalar", "avx2") can cap it, to compare
+// the kernels.
+WordsKernelChoice select_words_kernel() {
+    const char *cap = std::getenv("NAND_NATIVE_SIMD");
+    const bool scalar_only = cap != nullptr && std::strcmp(cap, "scalar") == 0;
+    const bool avx2_only = cap != nullptr && std::strcmp(cap, "avx2") == 0;
+#ifdef NAND_NATIVE_X86_DISPATCH
+    __builtin_cpu_init();
+    if (!scalar_only && !avx2_only && __builtin_cpu_supports("avx512f")) {
+        return {nand_words_avx512, "avx512"};
+    }
+    if (!scalar_only && __builtin_cpu_supports("avx2")) {
+        return {nand_words_avx2, "avx2"};
+    }
+#else
+    (void)scalar_only;
+    (void)avx2_only;
+#endif
+    return {nand_words_scalar, "scalar"};
+}
+
+WordsKernelChoice words_kernel = {nand_words_scalar, "scalar"};
+
+// A flat netlist and its wire state buffer.
+class Netlist {
+  public:
+    std::size_t wires_count = 0;
+    std::vector<Index> inputs;
+    std::vector<Index> outputs;
+    std::vector<Index> in_a;
+    std::vector<Index> in_b;
+    std::vector<Index> out;
+
+    // One byte per wire: 0 or 1. Only used with the GIL held.
+    std::vector<std::uint8_t> state;
+
+    void simulate() {
+        std::uint8_t *s = state.data();
+        const Index *a = in_a.data();
+        const Index *b = in_b.data();
+        const Index *o = out.data();
+        const std::size_t n = out.size();
+        for (std::size_t i = 0; i < n; ++i) {
+            s[o[i]] = static_cast<std::uint8_t>(!(s[a[i]] & s[b[i]]));
+        }
+    }
+
+    // The rows of words are owned by the caller: the GIL is released during a batch,
+    // so another thread can simulate the same netlist at the same time.
+    void simulate_words(Word *words_state, std::size_t words) const {
+        words_kernel.kernel(words_state, in_a.data(), in_b.data(), out.data(),
+                            out.size(), words);
+    }
+};
+
+struct KernelObject {
+    PyObject_HEAD Netlist *netlist;
+};
+
+// Convert a Python sequence of integers to wire indices, checking their bounds.
+bool to_indices(PyObject *sequence, const char *name, std::size_t wires_count,
+                std::vector<Index> &indices) {
+    PyObject *fast = PySequence_Fast(sequence, "expected a sequence of integers");
+    if (fast == nullptr) {
+        return false;
+    }
+    const Py_ssize_t size = PySequence_Fast_GET_SIZE(fast);
+    PyObject **items = PySequence_Fast_ITEMS(fast);
+    indices.resize(static_cast<std::size_t>(size));
+    for (Py_ssize_t i = 0; i < size; ++i) {
+        const long value = PyLong_AsLong(items[i]);
+        if (value == -1 && PyErr_Occurred()) {
+            Py_DECREF(fast);
+            return false;
+        }
+        if (value < 0 || static_cast<std::size_t>(value) >= wires_count) {
+            PyErr_Format(PyExc_ValueError,
+                         "Wire index %ld of '%s' is out of bounds (there is %zu wires).",
+                         value, name, wires_count);
+            Py_DECREF(fast);
+            return false;
+        }
+        indices[static_cast<std::size_t>(i)] = static_cast<Index>(value);
+    }
+    Py_DECREF(fast);
+    return true;
+}
+
+PyObject *to_bool_list(const Netlist &netlist) {
+    PyObject *list = PyList_New(static_cast<Py_ssize_t>(netlist.outputs.size()));
+    if (list == nullptr) {
+        return nullptr;
+    }
+    for (std::size_t i = 0; i < netlist.outputs.size(); ++i) {
+        PyObject *value = netlist.state[netlist.outputs[i]] ? Py_True : Py_False;
+        Py_INCREF(value);
+        PyList_SET_ITEM(list, static_cast<Py_ssize_t>(i), value);
+    }
+    return list;
+}
+
+// The batched kernel doesn't initialize its state buffer: each wire must be written,
+// as an input or the output of a gate, before being read by a gate or an output.
+bool check_written_before_read(const Netlist &netlist) {
+    std::vector<bool> written(netlist.wires_count, false);
+    for (const Index wire : netlist.inputs) {
+        written[static_cast<std::size_t>(wire)] = true;
+    }
+    for (std::size_t i = 0; i < netlist.out.size(); ++i) {
+        for (const Index wire : {netlist.in_a[i], netlist.in_b[i]}) {
+            if (!written[static_cast<std::size_t>(wire)]) {
+                PyErr_Format(PyExc_ValueError,
+                             "The gate %zu reads the wire %d before it is written.", i,
+                             static_cast<int>(wire));
+                return false;
+            }
+        }
+        written[static_cast<std::size_t>(netlist.out[i])] = true;
+    }
+    for (const Index wire : netlist.outputs) {
+        if (!written[static_cast<std::size_t>(wire)]) {
+            PyErr_Format(PyExc_ValueError, "The output wire %d is never written.",
+                         static_cast<int>(wire));
+            return false;
+        }
+    }
+    return true;
+}
+
+PyObject *Kernel_new(PyTypeObject *type, PyObject *, PyObject *) {
+    auto *self = reinterpret_cast<KernelObject *>(type->tp_alloc(type, 0));
+    if (self != nullptr) {
+        self->netlist = nullptr;
+    }
+    return reinterpret_cast<PyObject *>(self);
+}
+
+int Kernel_init(KernelObject *self, PyObject *args, PyObject *kwds) {
+    static const char *keywords[] = {"wires_count", "inputs", "outputs", "in_a",
+                                     "in_b",        "out",    nullptr};
+    Py_ssize_t wires_count = 0;
+    PyObject *inputs, *outputs, *in_a, *in_b, *out;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "nOOOOO", const_cast<char **>(keywords),
+                                     &wires_count, &inputs, &outputs, &in_a, &in_b,
+                                     &out)) {
+        return -1;
+    }
+    if (wires_count < 0) {
+        PyErr_SetString(PyExc_ValueError, "The number of wires must be positive.");
+        return -1;
+    }
+    // A batch reads the netlist without the GIL: replacing it could free it under a
+    // running batch.
+    if (self->netlist != nullptr) {
+        PyErr_SetString(PyExc_RuntimeError, "The kernel is already initialized.");
+        return -1;
+    }
+
+    auto *netlist = new (std::nothrow) Netlist();
+    if (netlist == nullptr) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    netlist->wires_count = static_cast<std::size_t>(wires_count);
+    if (!to_indices(inputs, "inputs", netlist->wires_count, netlist->inputs) ||
+        !to_indices(outputs, "outputs", netlist->wires_count, netlist->outputs) ||
+        !to_indices(in_a, "in_a", netlist->wires_count, netlist->in_a) ||
+        !to_indices(in_b, "in_b", netlist->wires_count, netlist->in_b) ||
+        !to_indices(out, "out", netlist->wires_count, netlist->out)) {
+        delete netlist;
+        return -1;
+    }
+    if (netlist->in_a.size() != netlist->out.size() ||
+        netlist->in_b.size() != netlist->out.size()) {
+        PyErr_SetString(PyExc_ValueError,
+                        "'in_a', 'in_b', and 'out' must have the same length.");
+        delete netlist;
+        return -1;
+    }
+    if (!check_written_before_read(*netlist)) {
+        delete netlist;
+        return -1;
+    }
+    netlist->state.assign(netlist->wires_count, 0);
+
+    self->netlist = netlist;
+    return 0;
+}
+
+void Kernel_dealloc(KernelObject *self) {
+    delete self->netlist;
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject *>(self));
+}
+
+bool check_initialized(KernelObject *self) {
+    if (self->netlist == nullptr) {
+        PyErr_SetString(PyExc_RuntimeError, "The kernel is not initialized.");
+        return false;
+    }
+    return true;
+}
+
+PyObject *Kernel_simulate(KernelObject *self, PyObject *inputs) {
+    if (!check_initialized(self)) {
+        return nullptr;
+    }
+    Netlist &netlist = *self->netlist;
+
+    PyObject *fast = PySequence_Fast(inputs, "expected a sequence of booleans");
+    if (fast == nullptr) {
+        return nullptr;
+    }
+    const std::size_t size = static_cast<std::size_t>(PySequence_Fast_GET_SIZE(fast));
+    PyObject **items = PySequence_Fast_ITEMS(fast);
+    // Like the other simulators, extra inputs are ignored.
+    for (std::size_t i = 0; i < size && i < netlist.inputs.size(); ++i) {
+        const int value = PyObject_IsTrue(items[i]);
+        if (value < 0) {
+            Py_DECREF(fast);
+            return nullptr;
+        }
+        netlist.state[netlist.inputs[i]] = static_cast<std::uint8_t>(value);
+    }
+    Py_DECREF(fast);
+
+    netlist.simulate();
+
+    return to_bool_list(netlist);
+}
+
+PyObject *Kernel_simulate_words(KernelObject *self, PyObject *args) {
+    if (!check_initialized(self)) {
+        return nullptr;
+    }
+    Netlist &netlist = *self->netlist;
+
+    Py_buffer inputs;
+    Py_ssize_t words = 0;
+    if (!PyArg_ParseTuple(args, "y*n", &inputs, &words)) {
+        return nullptr;
+    }
+    const std::size_t row_size = static_cast<std::size_t>(words) * sizeof(Word);
+    if (words <= 0 ||
+        static_cast<std::size_t>(inputs.len) != netlist.inputs.size() * row_size) {
+        PyErr_Format(PyExc_ValueError,
+                     "Expected %zu rows of %zd words of inputs (%zd bytes given).",
+                     netlist.inputs.size(), words, inputs.len);
+        PyBuffer_Release(&inputs);
+        return nullptr;
+    }
+
+    const std::size_t w = static_cast<std::size_t>(words);
+    // Every wire is written before being read (see 'check_written_before_read()'): the
+    // buffer doesn't need to be initialized.
+    std::unique_ptr<Word[]> words_state(new (std::nothrow)
+                                            Word[netlist.wires_count * w]);
+    if (words_state == nullptr) {
+        PyBuffer_Release(&inputs);
+        return PyErr_NoMemory();
+    }
+    const auto *rows = static_cast<const char *>(inputs.buf);
+    for (std::size_t i = 0; i < netlist.inputs.size(); ++i) {
+        Word *row = words_state.get() + static_cast<std::size_t>(netlist.inputs[i]) * w;
+        std::memcpy(row, rows + i * row_size, row_size);
+    }
+    PyBuffer_Release(&inputs);
+
+    // The batch can be long: other Python threads can run in the meantime.
+    Py_BEGIN_ALLOW_THREADS
+    netlist.simulate_words(words_state.get(), w);
+    Py_END_ALLOW_THREADS
+
+    const auto result_size = static_cast<Py_ssize_t>(netlist.outputs.size() * row_size);
+    PyObject *result = PyBytes_FromStringAndSize(nullptr, result_size);
+    if (result == nullptr) {
+        return nullptr;
+    }
+    char *output_rows = PyBytes_AS_STRING(result);
+    for (std::size_t i = 0; i < netlist.outputs.size(); ++i) {
+        const Word *row =
+            words_state.get() + static_cast<std::size_t>(netlist.outputs[i]) * w;
+        std::memcpy(output_rows + i * row_size, row, row_size);
+    }
+    return result;
+}
+
+PyObject *simd_level(PyObject *, PyObject *) {
+    return PyUnicode_FromString(words_kernel.name);
+}
+
+PyMethodDef Kernel_methods[] = {
+    {"simulate", reinterpret_cast<PyCFunction>(Kernel_simulate), METH_O,
+     "simulate(inputs) -> list[bool]\n\nSimulate the netlist with the given inputs."},
+    {"simulate_words", reinterpret_cast<PyCFunction>(Kernel_simulate_words),
+     METH_VARARGS,
+     "simulate_words(inputs, words) -> bytes\n\n"
+     "Simulate the netlist for a batch of input vectors. 'inputs' holds one row of\n"
+     "'words' 64 bits little-endian words per input, the result one row per output."},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+PyMethodDef module_methods[] = {
+    {"simd_level", simd_level, METH_NOARGS,
+     "simd_level() -> str\n\nThe instruction set used by the batched kernel."},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+PyTypeObject KernelType = {
+    PyVarObject_HEAD_INIT(nullptr, 0)
+};
+
+PyModuleDef native_module = {
+    PyModuleDef_HEAD_INIT,
+    "nand._native",
+    "Native simulation kernel of the flat netlists.",
+    -1,
+    module_methods,
+};
+
+} // namespace
+
+PyMODINIT_FUNC PyInit__native(void) {
+    words_kernel = select_words_kernel();
+
+    KernelType.tp_name = "nand._native.Kernel";
+    KernelType.tp_doc = "Kernel(wires_count, inputs, outputs, in_a, in_b, out)\n\n"
+                        "A flat netlist ready to be simulated natively.";
+    KernelType.tp_basicsize = sizeof(KernelObject);
+    KernelType.tp_flags = Py_TPFLAGS_DEFAULT;
+    KernelType.tp_new = Kernel_new;
+    KernelType.tp_init = reinterpret_cast<initproc>(Kernel_init);
+    KernelType.tp_dealloc = reinterpret_cast<destructor>(Kernel_dealloc);
+    KernelType.tp_methods = Kernel_methods;
+    if (PyType_Ready(&KernelType) < 0) {
+        return nullptr;
+    }
+
+    PyObject *module = PyModule_Create(&native_module);
+    if (module == nullptr) {
+        return nullptr;
+    }
+    Py_INCREF(&KernelType);
+    if (PyModule_AddObject(module, "Kernel", reinterpret_cast<PyObject *>(&KernelType)) <
+        0) {
+        Py_DECREF(&KernelType);
+        Py_DECREF(module);
+        return nullptr;
+    }
+    return module;
+}
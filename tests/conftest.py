@@ -1,9 +1,33 @@
+import os
+
 import pytest
 
+from nand.circuit_generators import default_library
+from nand.disk_cache import CACHE_DIR_ENV
 from nand.optimization_level import OptimizationLevel
 from tests.simulators_factory import BuildProcess, SimulatorsFactory
 
 
+@pytest.fixture(scope="session", autouse=True)
+def nand_cache_dir(tmp_path_factory):
+    """Keep the disk caches written by the tests out of the user cache directory."""
+    directory = tmp_path_factory.mktemp("nand_cache")
+    previous = os.environ.get(CACHE_DIR_ENV)
+    os.environ[CACHE_DIR_ENV] = str(directory)
+    yield directory
+    if previous is None:
+        del os.environ[CACHE_DIR_ENV]
+    else:
+        os.environ[CACHE_DIR_ENV] = previous
+
+
+@pytest.fixture
+def library():
+    """Fixture to provide a fresh library of the 'CircuitBuilder' circuits, which the
+    test is free to modify."""
+    return default_library()
+
+
 @pytest.fixture(scope="module")
 def simulators_factory():
     """Fixture to create a memoized SimulatorsFactory instance."""
@@ -76,7 +76,7 @@ class SimulatorsFactory:
         if (build_kind, optimization_level, encoder_type) not in self._simulators:
             library = self._circuits[build_kind, encoder_type]
             simulators = [
-                build_simulator(circuit, optimization_level)
+                build_simulator(circuit, optimization_level, library=library)
                 for circuit in library.get_all_circuits().values()
             ]
             self._simulators[(build_kind, optimization_level, encoder_type)] = (
@@ -0,0 +1,172 @@
+from contextlib import nullcontext
+from copy import deepcopy
+
+import pytest
+from nand.circuit import Circuit
+from nand.circuit_definition import (
+    DefinitionBuilder,
+    definition_to_circuit,
+    definitions_from_library,
+)
+from nand import circuit_optimizer
+from nand.circuit_optimizer import optimize, sort_components
+from nand.flat_netlist import flatten, flatten_definition
+from nand.simulator_compiled import SimulatorCompiled
+
+
+def test_optimizer_orders_components(monkeypatch, library):
+    """The components are sorted by dependency, once per circuit definition, and the
+    cycles are detected."""
+
+    chain = Circuit("Chain")
+    chain.add_component("NOT_2", library.get_circuit("NOT"))
+    chain.add_component("NOT_1", library.get_circuit("NOT"))
+    chain.connect_input("IN", "NOT_1", "IN")
+    chain.connect("NOT_1", "OUT", "NOT_2", "IN")
+    chain.connect_output("OUT", "NOT_2", "OUT")
+    orders = optimize(chain)
+    assert orders["Chain"].keys == ("NOT_1", "NOT_2")
+    assert list(chain.components) == ["NOT_2", "NOT_1"]
+
+    # Each identifier is sorted once, from its first instance.
+    adder = library.get_circuit("8-Bits Adder")
+    sorted_circuits = []
+
+    def counted_sort(circuit, structure):
+        sorted_circuits.append(circuit.identifier)
+        return sort_components(circuit, structure)
+
+    monkeypatch.setattr(circuit_optimizer, "sort_components", counted_sort)
+    assert optimize(adder, orders) is orders
+    assert {"8-Bits Adder", "4-Bits Adder", "Full-Adder", "XOR"} <= orders.keys()
+    assert len(sorted_circuits) == len(set(sorted_circuits))
+    sorted_circuits.clear()
+    optimize(library.get_circuit("8-Bits Adder"), orders)
+    assert sorted_circuits == []
+
+    # The same identifier and keys, but another wiring: the order is computed again.
+    reversed_chain = Circuit("Chain")
+    reversed_chain.add_component("NOT_2", library.get_circuit("NOT"))
+    reversed_chain.add_component("NOT_1", library.get_circuit("NOT"))
+    reversed_chain.connect_input("IN", "NOT_2", "IN")
+    reversed_chain.connect("NOT_2", "OUT", "NOT_1", "IN")
+    reversed_chain.connect_output("OUT", "NOT_1", "OUT")
+    optimize(reversed_chain, orders)
+    assert orders["Chain"].keys == ("NOT_2", "NOT_1")
+
+    loop = Circuit("Loop")
+    loop.add_component("NOT_1", library.get_circuit("NOT"))
+    loop.add_component("NOT_2", library.get_circuit("NOT"))
+    loop.connect("NOT_1", "OUT", "NOT_2", "IN")
+    loop.connect("NOT_2", "OUT", "NOT_1", "IN")
+    loop.connect_output("OUT", "NOT_2", "OUT")
+    with pytest.raises(ValueError):
+        optimize(loop)
+
+
+def test_definitions_shared(library):
+    """The circuit definitions are shared by their instances, and flatten to the same
+    netlists as the circuits."""
+    definitions = definitions_from_library(library)
+
+    eight_bits = definitions["8-Bits Adder"]
+    four_bits = [component.definition for component in eight_bits.components]
+    assert four_bits[0] is four_bits[1] is definitions["4-Bits Adder"]
+
+    netlist = flatten_definition(eight_bits)
+    reference = flatten(library.get_circuit("8-Bits Adder"))
+    assert netlist.inputs == reference.inputs
+    assert netlist.outputs == reference.outputs
+    assert list(netlist.in_a) == list(reference.in_a)
+    assert list(netlist.in_b) == list(reference.in_b)
+
+    # A 32-bits ripple-carry adder, built from the full adder definition: a component
+    # is a reference, not a copy.
+    ripple = DefinitionBuilder("32-Bits Adder")
+    for bit in range(32):
+        ripple.add_component(bit, definitions["Full-Adder"])
+        ripple.connect_input(f"A{bit}", bit, "A")
+        ripple.connect_input(f"B{bit}", bit, "B")
+        if bit == 0:
+            ripple.connect_input("C", bit, "Cin")
+        else:
+            ripple.connect(bit - 1, "Cout", bit, "Cin")
+        ripple.connect_output(f"S{bit}", bit, "SUM")
+    ripple.connect_output("C", 31, "Cout")
+    ripple_definition = ripple.build()
+    full_adder_nands = flatten_definition(definitions["Full-Adder"]).nands_count
+    assert flatten_definition(ripple_definition).nands_count == 32 * full_adder_nands
+
+    # Expanded back into a circuit, for the other simulators.
+    simulator = SimulatorCompiled(definition_to_circuit(ripple_definition))
+    a, b = 0xDEADBEEF, 0x12345678
+    inputs = [bit for i in range(32) for bit in ((a >> i) & 1, (b >> i) & 1)]
+    # The carry input is declared after the first bits.
+    inputs.insert(2, 0)
+    result = simulator.simulate([bool(bit) for bit in inputs])
+    assert result == [bool(((a + b) >> i) & 1) for i in range(33)]
+
+    cyclic = DefinitionBuilder("Loop")
+    cyclic.add_component("NOT_1", definitions["NOT"])
+    cyclic.add_component("NOT_2", definitions["NOT"])
+    cyclic.connect("NOT_1", "OUT", "NOT_2", "IN")
+    cyclic.connect("NOT_2", "OUT", "NOT_1", "IN")
+    with pytest.raises(ValueError):
+        cyclic.build()
+
+
+def test_deferred_wiring(library):
+    """A circuit built with its wiring deferred is the same as one built eagerly, even
+    when a connection replaces a wire already shared."""
+
+    def build(deferred: bool) -> Circuit:
+        ripple = Circuit("8-Bits Ripple Adder")
+        for bit in range(8):
+            ripple.add_component(bit, library.get_circuit("Full-Adder"))
+        with ripple.deferred_wiring() if deferred else nullcontext():
+            for bit in range(8):
+                ripple.connect_input(f"A{bit}", bit, "A")
+                ripple.connect_input(f"B{bit}", bit, "B")
+                # Connected to the carry input first, then to the previous carry.
+                ripple.connect_input("C", bit, "Cin")
+                if bit != 0:
+                    ripple.connect(bit - 1, "Cout", bit, "Cin")
+                ripple.connect_output(f"S{bit}", bit, "SUM")
+            ripple.connect_output("Cout", 7, "Cout")
+            assert (ripple.bindings is not None) == deferred
+        assert ripple.bindings is None
+        return ripple
+
+    reference = flatten(build(deferred=False))
+    for circuit in (build(deferred=True), deepcopy(build(deferred=True))):
+        netlist = flatten(circuit)
+        assert netlist.inputs == reference.inputs
+        assert netlist.outputs == reference.outputs
+        assert list(netlist.in_a) == list(reference.in_a)
+        assert list(netlist.in_b) == list(reference.in_b)
+
+    simulator = SimulatorCompiled(build(deferred=True))
+    a, b = 0b10110101, 0b01101110
+    # The carry input is declared after the first bits.
+    inputs = [a & 1, b & 1, 0]
+    inputs += [bit for i in range(1, 8) for bit in ((a >> i) & 1, (b >> i) & 1)]
+    result = simulator.simulate([bool(bit) for bit in inputs])
+    assert result == [bool(((a + b) >> i) & 1) for i in range(9)]
+
+
+def test_flatten_keeps_circuit(library):
+    """Flattening sorts the definitions, not the components of the circuit."""
+    adder = library.get_circuit("4-Bits Adder")
+    for component in adder.components.values():
+        component.components = dict(reversed(component.components.items()))
+    adder.components = dict(reversed(adder.components.items()))
+    orders = [list(adder.components)]
+    orders += [list(component.components) for component in adder.components.values()]
+
+    netlist = flatten(adder)
+    assert [list(adder.components)] + [
+        list(component.components) for component in adder.components.values()
+    ] == orders
+    reference = flatten(library.get_circuit("4-Bits Adder"))
+    assert netlist.nands_count == reference.nands_count
+    assert netlist.outputs == reference.outputs
@@ -0,0 +1,30 @@
+import io
+
+from nand.flat_netlist import flatten
+from nand.graph_stream import DotOptions, write_dot
+
+
+def test_dot_export(library):
+    """The streamed graph has a node per NAND gate, or per collapsed component."""
+    full_adder = library.get_circuit("Full-Adder")
+
+    text = io.StringIO()
+    writer = write_dot(full_adder, text)
+    netlist = flatten(full_adder)
+    assert writer.nodes_count == netlist.nands_count
+    edges = sum(len({a, b}) for a, b in zip(netlist.in_a, netlist.in_b))
+    assert writer.edges_count == edges + len(netlist.outputs)
+    assert text.getvalue().startswith('digraph "Circuit_Full-Adder" {')
+    assert text.getvalue().count("subgraph cluster_") == 7
+
+    # The XOR, AND, and OR gates of the full adder, as boxes.
+    text = io.StringIO()
+    writer = write_dot(full_adder, text, DotOptions(max_depth=0))
+    assert writer.nodes_count == len(full_adder.components)
+    assert "cluster" not in text.getvalue()
+    assert 'label="XOR", shape=component' in text.getvalue()
+
+    # Only the circuits of more than 2 gates are collapsed: the XOR and OR gates.
+    text = io.StringIO()
+    writer = write_dot(full_adder, text, DotOptions(max_gates=2))
+    assert writer.nodes_count == 3 + 2 * 2
@@ -1,11 +1,49 @@
+from copy import deepcopy
 from typing import Type
+
+import pytest
+from bitarray import bitarray
+
 from nand.bit_packed_decoder import BitPackedDecoder
 from nand.bit_packed_encoder import BitPackedEncoder
+from nand.bit_packed_loader import BitPackedLoader, load_netlist
+from nand.bits_utils import BitReader, BitWriter
 from nand.circuit_decoder import CircuitDecoder
 from nand.circuit_encoder import CircuitEncoder
 from nand.default_decoder import DefaultDecoder
+from nand.disk_cache import CACHE_DIR_ENV
 from nand.default_encoder import DefaultEncoder
-from nand.circuits_library import CircuitBuilder
+from nand.encoding_stats import compare_encoders
+from nand.entropy_decoder import EntropyDecoder
+from nand.entropy_encoder import EntropyEncoder
+from nand.circuit import Circuit
+from nand.circuit_generators import carry_lookahead_adder, default_library
+from nand.circuits_library import CircuitLibrary, library_from_circuit
+from nand.equivalence import equivalent
+from nand.flat_netlist import flatten, flatten_definition
+from nand.lazy_library import (
+    LazyCircuitLibrary,
+    encode_with_index,
+    open_library,
+    save_library,
+)
+from nand.netlist_cache import (
+    NetlistFile,
+    build_cached_simulator,
+    cached_netlists,
+    netlist_cache_key,
+    save_netlists,
+)
+from nand.optimization_level import OptimizationLevel
+from nand.range_coder import (
+    INITIAL_PROBABILITY,
+    MAX_INTEGER_BITLENGTH,
+    BitTreeModel,
+    IntegerModel,
+    RangeDecoder,
+    RangeEncoder,
+)
+from nand.simulator_builder import build_netlist_simulator
 
 
 def test_default_encoder():
@@ -16,14 +54,203 @@ def test_bit_packed_encoder():
     _test_roundtrip(BitPackedEncoder, BitPackedDecoder)
 
 
+def test_entropy_encoder(capsys, library):
+    _test_roundtrip(EntropyEncoder, EntropyDecoder)
+
+    encoding = EntropyEncoder().encode(library)
+    assert len(encoding) < len(BitPackedEncoder().encode(library))
+
+    # The decoded circuits are the same as the bit-packed ones.
+    decoded = EntropyDecoder().decode(encoding)
+    reference = BitPackedDecoder().decode(BitPackedEncoder().encode(library))
+    assert BitPackedEncoder().encode(decoded) == BitPackedEncoder().encode(reference)
+
+    compare_encoders(
+        [DefaultEncoder(), BitPackedEncoder(), EntropyEncoder()],
+        library,
+        [DefaultDecoder, BitPackedDecoder, EntropyDecoder],
+        repeats=1,
+        large_library=library_from_circuit(carry_lookahead_adder(32)),
+    )
+    output = capsys.readouterr().out
+    assert "EntropyEncoder" in output
+    assert output.count("components/s") == 3
+    # The default encoder can't encode the large library.
+    assert "- components/s" in output
+
+
+def test_range_coder_models():
+    """The inlined decoding of the models decodes what they encoded."""
+    values = [0, 1, 2, 3, 7, 1000, 5, 5, 5, 2**62 - 2, 0, 12]
+    encoder = RangeEncoder()
+    integers, trees = IntegerModel(), BitTreeModel(4)
+    for value in values:
+        integers.encode(encoder, value)
+        trees.encode(encoder, value % 16)
+    data = encoder.finish()
+
+    decoder = RangeDecoder(data)
+    integers, trees = IntegerModel(), BitTreeModel(4)
+    for value in values:
+        assert integers.decode(decoder) == value
+        assert trees.decode(decoder) == value % 16
+
+    with pytest.raises(ValueError):
+        IntegerModel().encode(RangeEncoder(), 2**63)
+    # The unary bit length never ends.
+    encoder = RangeEncoder()
+    lengths = [INITIAL_PROBABILITY] * MAX_INTEGER_BITLENGTH
+    for idx in range(MAX_INTEGER_BITLENGTH):
+        encoder.encode_bit(lengths, idx, 1)
+    with pytest.raises(ValueError):
+        IntegerModel().decode(RangeDecoder(encoder.finish()))
+
+
+def test_bit_packed_encoder_reused(library):
+    """An encoder starts a new stream, and new offsets, for each library."""
+    small = library_from_circuit(library.get_circuit("Full-Adder"))
+    reference = BitPackedEncoder()
+    reference_encoding = reference.encode(small)
+
+    encoder = BitPackedEncoder()
+    encoder.encode(library)
+    assert encoder.encode(small) == reference_encoding
+    assert encoder.circuit_offsets == reference.circuit_offsets
+
+
+def test_bit_reader():
+    data = bitarray("1011" "00000010" "1" "111")
+    reader = BitReader(data)
+    assert reader.read(4) == 0b1011
+    assert reader.read_byte() == 2
+    assert reader.read_bit() == 1
+    assert reader.read_with_offset(0) == 1
+    assert reader.remaining == 3
+    with pytest.raises(ValueError):
+        reader.read(4)
+    assert reader.read(3) == 0b111
+    assert reader.at_end()
+
+    # Bytes are read in place.
+    assert BitReader(bytes([0x12, 0x34]), start=4).read(8) == 0x23
+
+
+def test_bit_writer():
+    writer = BitWriter()
+    writer.write(0b1011, 4)
+    writer.write(2, 8)
+    writer.write_bit(1)
+    writer.write_with_offset(1, 0)
+    writer.write_with_offset(8, 3)
+    assert writer.data == bitarray("1011" "00000010" "1" "111")
+    assert writer.position == 16
+    with pytest.raises(ValueError):
+        writer.write(8, 3)
+    with pytest.raises(ValueError):
+        writer.write_with_offset(0, 3)
+
+
+def test_bit_packed_loader(library):
+    """Loading the stream directly gives the same netlists as decoding it."""
+    encoding = BitPackedEncoder().encode(library)
+
+    decoded = BitPackedDecoder().decode(encoding)
+    definitions = BitPackedLoader().load(encoding)
+    assert len(definitions) == len(decoded.library)
+    for idx, definition in definitions.items():
+        netlist = flatten_definition(definition)
+        reference = flatten(decoded.get_circuit_from_idx(idx))
+        assert netlist.inputs == reference.inputs
+        assert netlist.outputs == reference.outputs
+        assert list(netlist.in_a) == list(reference.in_a)
+        assert list(netlist.in_b) == list(reference.in_b)
+
+    # The last circuit is the 8-bits adder: 0b11111111 + 0b00000001
+    simulator = build_netlist_simulator(
+        load_netlist(encoding), OptimizationLevel.COMPILED
+    )
+    inputs = [True, True] + [False] + [True, False] * 7
+    assert simulator.simulate(inputs) == [False] * 8 + [True]
+
+    with pytest.raises(ValueError):
+        BitPackedLoader().load(encoding[:-3])
+
+
+def test_lazy_library(tmp_path, library):
+    """A circuit decoded alone from the index is the same as fully decoded."""
+    encoding, index = encode_with_index(library)
+    decoded = BitPackedDecoder().decode(encoding)
+
+    lazy = LazyCircuitLibrary(encoding, index)
+    assert len(lazy) == len(decoded.library)
+    # Only the first circuit and the NAND gate are decoded.
+    assert flatten(lazy.get_circuit(1)).out == flatten(decoded.get_circuit(1)).out
+    assert lazy.decoded_count == 2
+    with pytest.raises(ValueError):
+        lazy.get_circuit(len(lazy))
+
+    save_library(library, tmp_path / "library.bin")
+    with open_library(tmp_path / "library.bin") as opened:
+        last = len(opened) - 1
+        netlist = flatten(opened.get_circuit(last))
+        reference = flatten(decoded.get_circuit_from_idx(last))
+        assert list(netlist.in_a) == list(reference.in_a)
+        assert list(netlist.in_b) == list(reference.in_b)
+        assert netlist.outputs == reference.outputs
+        # The last circuit, its dependencies, and nothing else are decoded.
+        dependencies = set()
+        circuits = [decoded.get_circuit_from_idx(last)]
+        while circuits:
+            circuit = circuits.pop()
+            if circuit.identifier not in dependencies:
+                dependencies.add(circuit.identifier)
+                circuits.extend(circuit.components.values())
+        assert opened.decoded_count == len(dependencies) < len(decoded.library)
+    # Once closed, only the circuits already decoded are available.
+    assert opened.get_circuit(last).identifier == last
+    missing = next(idx for idx in range(len(opened)) if idx not in dependencies)
+    with pytest.raises(ValueError):
+        opened.get_circuit(missing)
+
+    with open_library(tmp_path / "library.bin") as opened:
+        opened.decode_all()
+        reencoded = BitPackedEncoder().encode(opened)
+    assert reencoded == encoding
+
+    # A library not matching its index is rejected.
+    with open(tmp_path / "library.bin", "ab") as file:
+        file.write(b"\0")
+    with pytest.raises(ValueError):
+        open_library(tmp_path / "library.bin")
+
+
+def test_lazy_library_deep_chain():
+    """A chain of circuits deeper than the recursion limit is decoded on demand."""
+    library = CircuitLibrary()
+    previous = BitPackedDecoder()._build_nand()
+    library.add_circuit(previous)
+    for idx in range(1, 500):
+        circuit = Circuit(idx)
+        with circuit.deferred_wiring():
+            circuit.add_component(0, previous)
+            circuit.connect_input(0, 0, 0)
+            circuit.connect_input(1, 0, 1)
+            circuit.connect_output(0, 0, 0)
+        library.add_circuit(circuit)
+        previous = circuit
+    encoding, index = encode_with_index(library)
+
+    lazy = LazyCircuitLibrary(encoding, index)
+    assert len(lazy.get_circuit(len(lazy) - 1).components) == 1
+    assert lazy.decoded_count == len(lazy)
+
+
 def _test_roundtrip(encoder: Type[CircuitEncoder], decoder: Type[CircuitDecoder]):
     """Test the round trip encoding and decoding.
 
     It tests the raw values of the encoding and decoding, not the actual circuits.
     """
-    builder = CircuitBuilder()
-    builder.build_circuits()
-    library = builder.library
+    library = default_library()
 
     reference_encoding = encoder().encode(library)
     round_trip_library = decoder().decode(reference_encoding)
@@ -41,3 +268,109 @@ def _test_roundtrip(encoder: Type[CircuitEncoder], decoder: Type[CircuitDecoder]
                     f"Encoding is different after round trip: "
                     f"Index {idx} is different: {a} != {b}"
                 )
+
+
+def test_round_trip_equivalence():
+    """The round trip of a 64 bits adder is proven equivalent without simulating its
+    2^129 input vectors."""
+    circuit = carry_lookahead_adder(64)
+    # The default encoder is limited to 255 components per circuit.
+    for encoder, decoder in [
+        (BitPackedEncoder, BitPackedDecoder),
+        (EntropyEncoder, EntropyDecoder),
+    ]:
+        library = library_from_circuit(deepcopy(circuit))
+        decoded = decoder().decode(encoder().encode(library))
+        # The circuits are decoded by index, the top-level one last.
+        top = decoded.get_circuit_from_idx(len(library.library) - 1)
+        result = equivalent(circuit, top)
+        assert result.equivalent is True
+        assert result.method == "structure"
+
+
+def test_netlist_cache(nand_cache_dir, library):
+    """The netlists are saved once, and mapped back identical from the cache."""
+    encoding = BitPackedEncoder().encode(library)
+
+    for level in (OptimizationLevel.COMPILED, OptimizationLevel.NATIVE):
+        built = cached_netlists(encoding, level)
+        with cached_netlists(encoding, level) as cached:
+            assert isinstance(cached, NetlistFile) and len(cached) == len(built)
+            for netlist, reference in zip(cached, built):
+                assert netlist.wires_count == reference.wires_count
+                assert netlist.inputs == reference.inputs
+                assert netlist.outputs == reference.outputs
+                assert list(netlist.in_a) == list(reference.in_a)
+                assert list(netlist.in_b) == list(reference.in_b)
+                assert list(netlist.out) == list(reference.out)
+                assert netlist.levels == reference.levels
+    # BIT_PARALLEL simulates the same netlists as COMPILED.
+    with cached_netlists(encoding, OptimizationLevel.BIT_PARALLEL) as shared:
+        assert isinstance(shared, NetlistFile)
+    paths = list((nand_cache_dir / "netlists").glob("*.bin"))
+    assert len(paths) == 2
+
+    # A truncated or empty file is built again when it's opened.
+    for path in paths:
+        data = path.read_bytes()
+        for corrupted in (data[: len(data) // 2], b""):
+            path.write_bytes(corrupted)
+            for level in (OptimizationLevel.COMPILED, OptimizationLevel.NATIVE):
+                netlists = cached_netlists(encoding, level)
+                assert len(netlists) == len(built)
+                if isinstance(netlists, NetlistFile):
+                    netlists.close()
+        assert path.read_bytes() == data
+
+    # An inconsistent netlist is only found when it's read: the other ones are still
+    # available, and the simulator built from it builds the file again.
+    # The last circuit is the 8-bits adder: 0b11111111 + 0b00000001
+    inputs = [True, True] + [False] + [True, False] * 7
+    for level in (OptimizationLevel.COMPILED, OptimizationLevel.NATIVE):
+        key = netlist_cache_key(encoding, level)
+        path = nand_cache_dir / "netlists" / f"{key}.bin"
+        data = path.read_bytes()
+        path.write_bytes(data[:-8] + b"\xff" * 8)
+        with cached_netlists(encoding, level) as netlists:
+            assert netlists[1].nands_count == 1
+            with pytest.raises(ValueError):
+                netlists[-1]
+        simulator = build_cached_simulator(encoding, level)
+        assert simulator.simulate(inputs) == [False] * 8 + [True]
+        assert path.read_bytes() == data
+
+    # Gates in range, but reading wires not written yet, are built again too.
+    path = nand_cache_dir / "netlists" / (
+        netlist_cache_key(encoding, OptimizationLevel.COMPILED) + ".bin"
+    )
+    data = path.read_bytes()
+    with cached_netlists(encoding, OptimizationLevel.COMPILED) as netlists:
+        unordered = list(netlists)
+    for netlist in unordered:
+        netlist.in_a, netlist.in_b = netlist.in_a[::-1], netlist.in_b[::-1]
+        netlist.out = netlist.out[::-1]
+    save_netlists(unordered, path)
+    simulator = build_cached_simulator(encoding, OptimizationLevel.COMPILED)
+    assert simulator.simulate(inputs) == [False] * 8 + [True]
+    assert path.read_bytes() == data
+
+    simulator = build_cached_simulator(encoding, OptimizationLevel.BIT_PARALLEL)
+    assert simulator.simulate(inputs) == [False] * 8 + [True]
+
+    with pytest.raises(ValueError):
+        cached_netlists(encoding, OptimizationLevel.FAST)
+    corrupted = nand_cache_dir / "corrupted.bin"
+    corrupted.write_bytes(b"NANDIDX1" + bytes(8))
+    with pytest.raises(ValueError):
+        NetlistFile(corrupted)
+
+
+def test_netlist_cache_unwritable(monkeypatch, tmp_path, library):
+    """The netlists are built without being saved when the cache can't be written."""
+    (tmp_path / "file").touch()
+    monkeypatch.setenv(CACHE_DIR_ENV, str(tmp_path / "file" / "cache"))
+    encoding = BitPackedEncoder().encode(library)
+
+    simulator = build_cached_simulator(encoding, OptimizationLevel.NATIVE)
+    inputs = [True, True] + [False] + [True, False] * 7
+    assert simulator.simulate(inputs) == [False] * 8 + [True]
@@ -0,0 +1,36 @@
+from copy import deepcopy
+
+import pytest
+from nand.circuit_generators import (
+    array_multiplier,
+    carry_lookahead_adder,
+    ripple_carry_adder,
+)
+from nand.equivalence import equivalent
+from nand.simulator_compiled import SimulatorCompiled
+
+
+def test_equivalence():
+    """Different adders are proven equivalent, and a bug gives a counterexample."""
+    result = equivalent(ripple_carry_adder(32), carry_lookahead_adder(32))
+    assert result.equivalent is True
+    assert result.method == "bdd"
+
+    # The carry out only differs from the high sum bit when they are swapped.
+    buggy = carry_lookahead_adder(8)
+    outputs = list(buggy.outputs.items())
+    outputs[-2], outputs[-1] = outputs[-1], outputs[-2]
+    buggy.outputs = dict(outputs)
+    reference = ripple_carry_adder(8)
+    for vectors, method in ((1024, "simulation"), (0, "bdd")):
+        result = equivalent(reference, buggy, vectors=vectors)
+        assert result.equivalent is False
+        assert result.method == method
+        counterexample = result.counterexample
+        assert counterexample is not None
+        assert SimulatorCompiled(deepcopy(reference)).simulate(
+            counterexample
+        ) != SimulatorCompiled(deepcopy(buggy)).simulate(counterexample)
+
+    with pytest.raises(ValueError):
+        equivalent(reference, array_multiplier(4))
@@ -0,0 +1,38 @@
+import itertools
+from typing import List, Optional
+
+from nand.fault_simulation import Fault, all_faults, simulate_faults
+from nand.flat_netlist import flatten
+
+
+def test_fault_simulation(library):
+    """The fault simulation detects the same faults as a simulation of each faulty
+    netlist, vector by vector."""
+    circuit = library.get_circuit("Full-Adder")
+    netlist = flatten(circuit)
+
+    def simulate(inputs: List[bool], fault: Optional[Fault]) -> List[bool]:
+        state = [False] * netlist.wires_count
+        for idx, value in zip(netlist.inputs, inputs):
+            state[idx] = value
+        if fault is not None and fault.wire in netlist.inputs:
+            state[fault.wire] = fault.stuck_at
+        for a, b, out in zip(netlist.in_a, netlist.in_b, netlist.out):
+            state[out] = not (state[a] and state[b])
+            if fault is not None and out == fault.wire:
+                state[out] = fault.stuck_at
+        return [state[idx] for idx in netlist.outputs]
+
+    vectors = [list(v) for v in itertools.product([False, True], repeat=3)]
+    # With only half of the vectors, some faults are not detected.
+    for vector_set, lanes in ((vectors, 3), (vectors[::2], 64)):
+        report = simulate_faults(circuit, vector_set, lanes=lanes, netlist=netlist)
+        expected = {}
+        for fault in all_faults(netlist):
+            for idx, inputs in enumerate(vector_set):
+                if simulate(inputs, fault) != simulate(inputs, None):
+                    expected[fault] = idx
+                    break
+        assert report.detected == expected
+        assert len(report.detected) + len(report.undetected) == len(report.faults)
+    assert report.coverage < 1.0
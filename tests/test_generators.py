@@ -0,0 +1,86 @@
+import random
+from typing import Callable, Dict, List
+
+import pytest
+from nand.circuit import Circuit
+from nand.circuit_generators import (
+    array_multiplier,
+    carry_lookahead_adder,
+    comparator,
+    default_library,
+    multiplexer_tree,
+    ripple_carry_adder,
+)
+from nand.simulator_builder import OptimizationLevel, build_simulator
+
+LIBRARY = default_library()
+
+
+def _number(values: Dict[str, bool], prefix: str, bits: int) -> int:
+    return sum(values[f"{prefix}{bit}"] << bit for bit in range(bits))
+
+
+def _bits(number: int, bits: int) -> List[bool]:
+    return [bool(number >> bit & 1) for bit in range(bits)]
+
+
+def _check(
+    circuit: Circuit,
+    expected: Callable[[Dict[str, bool]], List[bool]],
+    vectors: int = 64,
+):
+    """Simulate random vectors, and compare the outputs to the expected ones."""
+    rng = random.Random(0)
+    simulator = build_simulator(circuit, OptimizationLevel.COMPILED)
+    names = [str(input_id) for input_id in circuit.inputs]
+    for _ in range(vectors):
+        values = {name: rng.random() < 0.5 for name in names}
+        outputs = simulator.simulate([values[name] for name in names])
+        assert outputs == expected(values), values
+
+
+@pytest.mark.parametrize("bits", [1, 2, 5, 8])
+@pytest.mark.parametrize("generator", [ripple_carry_adder, carry_lookahead_adder])
+def test_adders(generator, bits: int):
+    def expected(values):
+        total = _number(values, "A", bits) + _number(values, "B", bits) + values["C0"]
+        return _bits(total, bits + 1)
+
+    circuit = generator(bits, LIBRARY)
+    assert len(circuit.inputs) == 2 * bits + 1
+    _check(circuit, expected)
+
+
+@pytest.mark.parametrize("bits", [1, 2, 5])
+def test_array_multiplier(bits: int):
+    def expected(values):
+        product = _number(values, "A", bits) * _number(values, "B", bits)
+        return _bits(product, 2 * bits)
+
+    _check(array_multiplier(bits, LIBRARY), expected)
+
+
+@pytest.mark.parametrize("bits", [1, 2, 5])
+def test_comparator(bits: int):
+    def expected(values):
+        a, b = _number(values, "A", bits), _number(values, "B", bits)
+        return [a < b, a == b, a > b]
+
+    _check(comparator(bits, LIBRARY), expected)
+
+
+@pytest.mark.parametrize("select_bits", [1, 2, 3])
+def test_multiplexer_tree(select_bits: int):
+    def expected(values):
+        return [values[f"D{_number(values, 'S', select_bits)}"]]
+
+    _check(multiplexer_tree(select_bits, LIBRARY), expected)
+
+
+def test_generators_are_flat():
+    """The gates are direct components of the generated circuit, so the construction
+    stays linear in its size."""
+    circuit = array_multiplier(16, LIBRARY)
+    assert len(circuit.components) == 16 * 16 + 15 * 16
+    with pytest.raises(ValueError):
+        ripple_carry_adder(0, LIBRARY)
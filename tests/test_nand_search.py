@@ -0,0 +1,32 @@
+import itertools
+
+import pytest
+from nand.nand_search import find_minimal_network, input_tables
+from nand.simulator_compiled import SimulatorCompiled
+
+
+def test_nand_search(library):
+    """The minimal networks of the 2 inputs gates, and of the 3 inputs majority."""
+    a, b = input_tables(2)
+    expected = {a & b: 2, a | b: 3, a ^ b: 4, 15 ^ (a ^ b): 5, 15 ^ (a | b): 4}
+    for table, gates_count in expected.items():
+        network = find_minimal_network(table, 2)
+        assert network is not None
+        assert len(network.gates) == gates_count
+        assert network.truth_table() == table
+
+    # The carry of a full adder, the search split between two workers.
+    x, y, z = input_tables(3)
+    majority = (x & y) | (x & z) | (y & z)
+    network = find_minimal_network(majority, 3, workers=2)
+    assert network is not None
+    assert len(network.gates) == 6
+
+    library.add_circuit(network.to_circuit("MAJORITY", library=library))
+    simulator = SimulatorCompiled(library.get_circuit("MAJORITY"))
+    for inputs in itertools.product([False, True], repeat=3):
+        assert simulator.simulate(inputs) == [sum(inputs) >= 2]
+
+    assert find_minimal_network(x ^ y ^ z, 3, max_gates=4) is None
+    with pytest.raises(ValueError):
+        find_minimal_network(0, 6)
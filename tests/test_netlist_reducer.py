@@ -0,0 +1,36 @@
+from copy import deepcopy
+import itertools
+
+import pytest
+from nand.circuit_generators import array_multiplier
+from nand.flat_netlist import flatten
+from nand.netlist_reducer import reduce_netlist
+from nand.simulator_builder import OptimizationLevel, build_simulator
+from nand.simulator_compiled import SimulatorCompiled
+
+
+def test_reduce_netlist(library):
+    """The reduced netlists compute the same outputs with fewer gates."""
+
+    # A single bit multiplier has a constant output: the high bit of the product.
+    circuits = [
+        (library.get_circuit("Full-Adder"), 9),
+        (library.get_circuit("8-Bits Adder"), 72),
+        (array_multiplier(1, library), 5),
+    ]
+    for circuit, nands_count in circuits:
+        netlist = flatten(circuit)
+        reduced, stats = reduce_netlist(netlist)
+        assert stats.nands_before == netlist.nands_count
+        assert stats.nands_after == reduced.nands_count == nands_count
+
+        reference = SimulatorCompiled(circuit)
+        simulator = build_simulator(
+            deepcopy(circuit), OptimizationLevel.COMPILED, reduce=True
+        )
+        assert simulator.netlist.nands_count == nands_count
+        for inputs in itertools.product([False, True], repeat=len(circuit.inputs)):
+            assert simulator.simulate(inputs) == reference.simulate(inputs)
+
+    with pytest.raises(ValueError):
+        build_simulator(circuit, OptimizationLevel.FAST, reduce=True)
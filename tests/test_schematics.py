@@ -7,7 +7,10 @@ from typing import Callable, List, Tuple
 import pytest
 from nand.circuit import Circuit
 from nand.simulator import Simulator
+from nand.simulator_bit_parallel import BatchSimulator
 from nand.simulator_builder import OptimizationLevel
+from nand.simulator_gpu import is_gpu_available
+from nand.simulator_native import is_native_available
 from tests.numeric_operations import (
     NumericOperations,
     bools_to_int,
@@ -21,23 +24,44 @@ def build_parameters():
 
     The parameters are a combination of:
     - BuildProcess: REFERENCE, ROUND_TRIP
-    - OptimizationLevel: FAST, DEBUG
+    - OptimizationLevel: FAST, DEBUG, COMPILED, BIT_PARALLEL, NATIVE, INCREMENTAL,
+      LOOKUP_TABLE, CODEGEN, GPU
     - EncoderType: DEFAULT, BIT_PACKED
 
     The DEBUG optimization level is marked as 'debug' to be able to run it
-    separately.
+    separately. The NATIVE optimization level is skipped if the native extension
+    wasn't built, and the GPU one if CuPy or a CUDA device isn't available.
     """
     params = []
 
     processes = [BuildProcess.REFERENCE, BuildProcess.ROUND_TRIP]
-    opt_levels = [OptimizationLevel.FAST, OptimizationLevel.DEBUG]
+    opt_levels = [
+        OptimizationLevel.FAST,
+        OptimizationLevel.DEBUG,
+        OptimizationLevel.COMPILED,
+        OptimizationLevel.BIT_PARALLEL,
+        OptimizationLevel.NATIVE,
+        OptimizationLevel.INCREMENTAL,
+        OptimizationLevel.LOOKUP_TABLE,
+        OptimizationLevel.CODEGEN,
+        OptimizationLevel.GPU,
+    ]
     encoders = [EncoderType.DEFAULT, EncoderType.BIT_PACKED]
     for p, o, e in itertools.product(processes, opt_levels, encoders):
-        mark_debug = pytest.mark.debug if o is OptimizationLevel.DEBUG else None
-        if mark_debug:
-            params.append(pytest.param((p, o, e), marks=mark_debug))
-        else:
-            params.append(pytest.param((p, o, e)))
+        marks = []
+        if o is OptimizationLevel.DEBUG:
+            marks.append(pytest.mark.debug)
+        if o is OptimizationLevel.NATIVE:
+            marks.append(
+                pytest.mark.skipif(
+                    not is_native_available(), reason="native extension not built"
+                )
+            )
+        if o is OptimizationLevel.GPU:
+            marks.append(
+                pytest.mark.skipif(not is_gpu_available(), reason="no CuPy GPU")
+            )
+        params.append(pytest.param((p, o, e), marks=marks))
     return params
 
 
@@ -109,6 +133,14 @@ class TestLibrary:
 
         all_possible_inputs = list(product([True, False], repeat=n_inputs))
 
+        # A batch simulator evaluates all the cases at once, there's no need to
+        # distribute them.
+        if isinstance(simulator, BatchSimulator):
+            results = simulator.simulate_batch(all_possible_inputs)
+            for inputs, result in zip(all_possible_inputs, results):
+                assert result == operations.apply(inputs)
+            return
+
         cases = [(simulator, operations, inputs) for inputs in all_possible_inputs]
 
         if n_inputs >= 16:
@@ -137,7 +169,7 @@ class TestLibrary:
             #   - Parallel simulation using circuit partitioning
             #   - Using lower-level libraries (Cython, Numba, NumPy, CuPy, etc.)
             cpu_count = multiprocessing.cpu_count()
-            n_processes = cpu_count - 1
+            n_processes = max(1, cpu_count - 1)
             chunk_size = max(1, n_tasks // (n_processes * 4))
 
             with ProcessPoolExecutor(max_workers=n_processes) as executor:
@@ -0,0 +1,55 @@
+import random
+
+from nand.circuit import Circuit
+from nand.circuit_generators import accumulator, d_flip_flop, d_latch
+from nand.simulator_bit_parallel import pack_lanes, unpack_lanes
+from nand.simulator_builder import OptimizationLevel
+from nand.simulator_sequential import SimulatorSequential
+from tests.numeric_operations import bools_to_int, int_to_bools
+
+
+def test_sequential_simulation(library):
+    """The latches hold their value, the flip-flops are triggered by the rising edge
+    of the clock, and the accumulator adds its input at each clock cycle."""
+    latch = SimulatorSequential(d_latch())
+    assert latch.simulate([True, True]) == [True, False]
+    assert latch.simulate([False, False]) == [True, False]
+    assert latch.simulate([False, True]) == [False, True]
+    assert latch.simulate([True, False]) == [False, True]
+
+    flip_flop = SimulatorSequential(d_flip_flop(), clock="CLK")
+    assert flip_flop.tick([True]) == [True, False]
+    assert flip_flop.simulate([False, False]) == [True, False]
+    assert flip_flop.simulate([False, True]) == [False, True]
+    assert flip_flop.simulate([True, True]) == [False, True]
+
+    bits, lanes = 4, 16
+    to_bools = int_to_bools(bits)
+    rng = random.Random(0)
+    simulator = SimulatorSequential(accumulator(bits), clock="CLK")
+    batched = SimulatorSequential(
+        accumulator(bits), OptimizationLevel.BIT_PARALLEL, clock="CLK"
+    )
+    # The value at power-on is arbitrary.
+    total = bools_to_int(simulator.tick(to_bools(0)))
+    words = batched.tick_words([0] * bits, lanes)
+    totals = [bools_to_int(row) for row in unpack_lanes(words, lanes)]
+    for _ in range(10):
+        x = rng.randrange(1 << bits)
+        total = (total + x) % (1 << bits)
+        assert bools_to_int(simulator.tick(to_bools(x))) == total
+
+        xs = [rng.randrange(1 << bits) for _ in range(lanes)]
+        words = batched.tick_words(pack_lanes([to_bools(x) for x in xs]), lanes)
+        totals = [(t + x) % (1 << bits) for t, x in zip(totals, xs)]
+        assert [bools_to_int(row) for row in unpack_lanes(words, lanes)] == totals
+
+    # A NAND gate reading its own output oscillates while enabled.
+    ring = Circuit("RING")
+    ring.add_component(0, library.get_circuit(0))
+    ring.connect_input("EN", 0, "A")
+    ring.connect(0, "OUT", 0, "B")
+    ring.connect_output("OUT", 0, "OUT")
+    oscillator = SimulatorSequential(ring)
+    assert oscillator.simulate([False]) == [True]
+    assert oscillator.simulate([True]) is False
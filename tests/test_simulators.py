@@ -0,0 +1,306 @@
+from concurrent.futures import ThreadPoolExecutor
+from copy import deepcopy
+import itertools
+import random
+
+import pytest
+from nand.bit_packed_encoder import BitPackedEncoder
+from nand.circuit import Circuit
+from nand.circuit_generators import array_multiplier, default_library
+from nand.disk_cache import CACHE_DIR_ENV
+from nand.flat_netlist import flatten
+from nand.simulator_bit_parallel import BatchSimulator
+from nand.simulator_builder import OptimizationLevel, build_simulator
+from nand.simulator_codegen import SimulatorCodegen, circuit_cache_key
+from nand.simulator_compiled import SimulatorCompiled
+from nand.simulator_debug import SimulatorDebug, UnresolvedComponent
+from nand.simulator_incremental import SimulatorIncremental
+from nand.simulator_instrumented import build_instrumented_simulator
+from nand.simulator_lookup_table import SimulatorLookupTable, library_tables
+from nand.simulator_native import is_native_available
+from nand.simulator_three_valued import SimulatorThreeValued
+from nand.wire import Wire
+from nand.wire_extended_state import WireExtendedState
+
+
+def test_incremental_activity(library):
+    """Flipping a single input of the incremental simulator only re-evaluates the
+    gates affected by this input."""
+    simulator = SimulatorIncremental(library.get_circuit("8-Bits Adder"))
+    nands_count = simulator.netlist.nands_count
+
+    # No change, no evaluation.
+    simulator.simulate([False] * 17)
+    assert simulator.last_step_evaluations == 0
+
+    # B7 (the last input) only affects the last full adder.
+    simulator.set_input(16, True)
+    assert simulator.step()[7:] == [True, False]
+    assert 0 < simulator.last_step_evaluations < nands_count // 4
+
+    # A carry propagated through all the adders: 0b11111111 + 0b00000001.
+    inputs = [True, True] + [False] + [True, False] * 7
+    result = simulator.simulate(inputs)
+    assert result == [False] * 8 + [True]
+
+
+def test_lookup_tables_shared(library):
+    """The small sub-circuits are table lookups, and their tables are computed once per
+    library."""
+
+    # The 8-bits adder is two 4-bits adders (9 inputs), each of them being two 2-bits
+    # adders (5 inputs): 4 lookups into the same table.
+    simulator = SimulatorLookupTable(library.get_circuit("8-Bits Adder"), library)
+    assert simulator.tables_count == 4
+    assert list(library_tables(library)) == ["2-Bits Adder"]
+    table = library_tables(library)["2-Bits Adder"]
+
+    # 0b11111111 + 0b00000001
+    inputs = [True, True] + [False] + [True, False] * 7
+    assert simulator.simulate(inputs) == [False] * 8 + [True]
+
+    other = SimulatorLookupTable(library.get_circuit("8-Bits Adder"), library)
+    assert library_tables(library)["2-Bits Adder"] is table
+    assert other.simulate(inputs) == [False] * 8 + [True]
+
+    # The tables are computed from copies: the library's circuits aren't optimized.
+    library.library["2-Bits Adder"].components = dict(
+        reversed(library.library["2-Bits Adder"].components.items())
+    )
+    encoding = BitPackedEncoder().encode(library)
+    library_tables(library).clear()
+    build_simulator(
+        library.get_circuit("4-Bits Adder"),
+        OptimizationLevel.LOOKUP_TABLE,
+        library=library,
+    )
+    assert list(library_tables(library)) == ["2-Bits Adder"]
+    assert BitPackedEncoder().encode(library) == encoding
+
+    # Without a library, the tables are computed from the instances: the full adder
+    # is made of 2 XOR, 2 AND and 1 OR gates.
+    gates = SimulatorLookupTable(library.get_circuit("Full-Adder"), max_inputs=2)
+    assert gates.tables_count == 5
+    assert gates.simulate([True, True, True]) == [True, True]
+
+
+def test_codegen_cache(nand_cache_dir, library):
+    """The generated code is saved once, and reused by the equivalent circuits."""
+
+    simulator = SimulatorCodegen(library.get_circuit("8-Bits Adder"))
+    sources = list((nand_cache_dir / "codegen").glob("*.py"))
+    key = circuit_cache_key(library.get_circuit("8-Bits Adder"))
+    assert sources and any(key in path.name for path in sources)
+
+    inputs = [True, True] + [False] + [True, False] * 7
+    assert simulator.simulate(inputs) == [False] * 8 + [True]
+
+    # A rebuilt library has other wires, but the same encoding.
+    rebuilt = default_library()
+    assert circuit_cache_key(rebuilt.get_circuit("8-Bits Adder")) == key
+    other = SimulatorCodegen(rebuilt.get_circuit("8-Bits Adder"))
+    assert list((nand_cache_dir / "codegen").glob("*.py")) == sources
+    assert other.simulate(inputs) == [False] * 8 + [True]
+
+    # Another circuit, another key.
+    assert circuit_cache_key(library.get_circuit("4-Bits Adder")) != key
+
+
+def test_codegen_without_cache(monkeypatch, tmp_path, library):
+    """The code is generated in memory when the cache directory can't be created."""
+    (tmp_path / "file").touch()
+    monkeypatch.setenv(CACHE_DIR_ENV, str(tmp_path / "file" / "cache"))
+    simulator = build_simulator(
+        library.get_circuit("Full-Adder"), OptimizationLevel.CODEGEN
+    )
+    assert simulator.simulate([True, True, False]) == [False, True]
+
+
+def test_instrumented_simulators(library):
+    """The instrumented simulators count the evaluations of each circuit, and the
+    failures of the DEBUG simulator on incorrect circuits."""
+    nands_count = flatten(library.get_circuit("Full-Adder")).nands_count
+
+    for level in (OptimizationLevel.DEBUG, OptimizationLevel.FAST):
+        simulator = build_instrumented_simulator(
+            library.get_circuit("Full-Adder"), level
+        )
+        for inputs in itertools.product([False, True], repeat=3):
+            assert simulator.simulate(inputs) == [
+                sum(inputs) % 2 == 1,
+                sum(inputs) >= 2,
+            ]
+        stats = simulator.stats
+        assert stats.runs == 8
+        assert stats.nand_evaluations == 8 * nands_count
+        assert stats.circuits["XOR"].evaluations == 8 * 2
+        assert stats.failures == 0
+        assert "Full-Adder" in stats.report()
+
+    # The OR reads a wire driven by nothing: it fails, and so does the full adder.
+    full_adder = library.get_circuit("Full-Adder")
+    full_adder.components["OR"].inputs["B"] = Wire()
+    simulator = build_instrumented_simulator(full_adder, OptimizationLevel.DEBUG)
+    assert simulator.simulate([True, True, False]) is False
+    assert simulator.stats.failures == 1
+    assert simulator.stats.circuits["Full-Adder"].failures == 1
+    assert "OR" not in simulator.stats.circuits
+
+    with pytest.raises(ValueError):
+        build_instrumented_simulator(full_adder, OptimizationLevel.COMPILED)
+
+
+def test_debug_unresolved_components(library):
+    """The DEBUG simulator schedules the components in any order, and reports the
+    components left unresolved by an incorrect circuit."""
+
+    # The components of each adder in the reverse order.
+    adder = library.get_circuit("4-Bits Adder")
+    for component in adder.components.values():
+        component.components = dict(reversed(component.components.items()))
+    adder.components = dict(reversed(adder.components.items()))
+    simulator = SimulatorDebug(adder)
+    a, b = 0b1011, 0b0110
+    inputs = [a & 1, b & 1, 0]
+    inputs += [bit for i in range(1, 4) for bit in (a >> i & 1, b >> i & 1)]
+    assert simulator.simulate([bool(bit) for bit in inputs]) == [
+        bool((a + b) >> i & 1) for i in range(5)
+    ]
+    assert simulator.unresolved == []
+
+    # A loop: the carry output of the full adder back into its first XOR.
+    looped = library.get_circuit("Full-Adder")
+    looped.connect("OR", "OUT", "XOR_ONE", "B")
+    simulator = SimulatorDebug(looped)
+    assert simulator.simulate([True, False, True]) is False
+    assert {component.path for component in simulator.unresolved} == {
+        ("XOR_ONE",),
+        ("XOR_TWO",),
+        ("AND_TWO",),
+        ("OR",),
+    }
+    xor_one = next(c for c in simulator.unresolved if c.path == ("XOR_ONE",))
+    assert xor_one == UnresolvedComponent(("XOR_ONE",), "XOR", ("B",))
+
+    # A component exposing the same wire on two outputs, read by a gate whose other
+    # input is only known later.
+    nand = library.get_circuit(0)
+    split = Circuit("SPLIT")
+    split.add_component("NAND", deepcopy(nand))
+    split.connect_input("A", "NAND", "A")
+    split.connect_input("A", "NAND", "B")
+    split.connect_output("X", "NAND", "OUT")
+    split.connect_output("Y", "NAND", "OUT")
+    circuit = Circuit("SHARED")
+    circuit.add_component("SPLIT", split)
+    circuit.add_component("EARLY", deepcopy(nand))
+    circuit.add_component("READER", deepcopy(nand))
+    circuit.add_component("LATE", deepcopy(nand))
+    circuit.connect_input("A", "SPLIT", "A")
+    circuit.connect_input("B", "EARLY", "A")
+    circuit.connect_input("B", "EARLY", "B")
+    circuit.connect("EARLY", "OUT", "LATE", "A")
+    circuit.connect("EARLY", "OUT", "LATE", "B")
+    circuit.connect("SPLIT", "X", "READER", "A")
+    circuit.connect("LATE", "OUT", "READER", "B")
+    circuit.connect_output("OUT", "READER", "OUT")
+    simulator = SimulatorDebug(circuit)
+    # NAND(NOT A, B)
+    assert [simulator.simulate(inputs) for inputs in ([True, True], [False, True])] == [
+        [True],
+        [False],
+    ]
+
+
+def test_three_valued_simulation(library):
+    """The three-valued simulator knows an output whenever the known inputs determine
+    it at each gate, and its known outputs are the ones of all the completions of the
+    unknown inputs."""
+    ON, OFF, UNKNOWN = (
+        WireExtendedState.ON,
+        WireExtendedState.OFF,
+        WireExtendedState.UNKNOWN,
+    )
+
+    lenient = SimulatorThreeValued(library.get_circuit("Full-Adder"), lanes=64)
+    strict = SimulatorThreeValued(
+        library.get_circuit("Full-Adder"), lanes=64, strict=True
+    )
+    # 1 + 1 + X: the sum is unknown, not the carry.
+    assert lenient.simulate_states([[True, True, UNKNOWN]]) == [[UNKNOWN, ON]]
+    assert strict.simulate_states([[True, True, UNKNOWN]]) == [[UNKNOWN, UNKNOWN]]
+    assert strict.simulate_states([[ON, OFF, OFF]]) == [[ON, OFF]]
+
+    circuit = library.get_circuit("4-Bits Adder")
+    reference = SimulatorCompiled(library.get_circuit("4-Bits Adder"))
+    simulators = [
+        SimulatorThreeValued(deepcopy(circuit), lanes=64, strict=strict)
+        for strict in (False, True)
+    ]
+    rng = random.Random(0)
+    vectors = [
+        [rng.choice([True, False, UNKNOWN]) for _ in circuit.inputs] for _ in range(100)
+    ]
+    lenient_results, strict_results = [s.simulate_states(vectors) for s in simulators]
+    for vector, lenient_outputs, strict_outputs in zip(
+        vectors, lenient_results, strict_results
+    ):
+        unknowns = [idx for idx, state in enumerate(vector) if state is UNKNOWN]
+        completions = []
+        for values in itertools.product([False, True], repeat=len(unknowns)):
+            completion = list(vector)
+            for idx, value in zip(unknowns, values):
+                completion[idx] = value
+            completions.append(reference.simulate(completion))
+        for output_idx, (lenient_state, strict_state) in enumerate(
+            zip(lenient_outputs, strict_outputs)
+        ):
+            if strict_state is not UNKNOWN:
+                assert lenient_state is strict_state
+            if lenient_state is not UNKNOWN:
+                expected = lenient_state is ON
+                assert all(outputs[output_idx] == expected for outputs in completions)
+        if len(unknowns) == 0:
+            assert [state is ON for state in lenient_outputs] == completions[0]
+
+
+@pytest.mark.skipif(not is_native_available(), reason="native extension not built")
+def test_native_threads():
+    """Threads sharing a native simulator each get their own batch: the GIL is
+    released during the simulation."""
+    simulator = build_simulator(array_multiplier(8), OptimizationLevel.NATIVE)
+    assert isinstance(simulator, BatchSimulator)
+    rng = random.Random(0)
+    batches = []
+    for lanes in (64, 1000, 4096, 10000):
+        inputs = [rng.getrandbits(lanes) for _ in range(16)]
+        batches.append((inputs, lanes, simulator.simulate_words(inputs, lanes)))
+
+    def run(batch) -> bool:
+        inputs, lanes, expected = batch
+        return all(
+            simulator.simulate_words(inputs, lanes) == expected for _ in range(20)
+        )
+
+    with ThreadPoolExecutor(max_workers=4) as executor:
+        assert all(executor.map(run, batches * 2))
+
+
+@pytest.mark.skipif(not is_native_available(), reason="native extension not built")
+def test_native_kernel_checks():
+    """The kernel rejects a netlist reading a wire before it's written, and can't be
+    initialized again while a batch may be reading its netlist."""
+    from nand import _native  # type: ignore[attr-defined]
+
+    # NOT A: the gate reads the input twice.
+    kernel = _native.Kernel(2, [0], [1], [0], [0], [1])
+    assert kernel.simulate([True]) == [False]
+    with pytest.raises(RuntimeError):
+        kernel.__init__(2, [0], [1], [0], [0], [1])
+    assert kernel.simulate([False]) == [True]
+
+    # The wire 1 is read by the first gate, and written by the second one.
+    with pytest.raises(ValueError):
+        _native.Kernel(3, [0], [2], [0, 0], [1, 0], [2, 1])
+    with pytest.raises(ValueError):
+        _native.Kernel(3, [0], [2], [0], [0], [1])
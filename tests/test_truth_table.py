@@ -0,0 +1,82 @@
+import pytest
+from nand.optimization_level import OptimizationLevel
+from nand.simulator_bit_parallel import counter_inputs
+from nand.simulator_gpu import is_gpu_available
+from nand.truth_table import exhaustive_truth_table
+from tests.numeric_operations import bools_to_int, int_to_bools
+
+
+def test_counter_inputs():
+    """The aligned patterns are the same as the enumerated vectors."""
+    aligned = counter_inputs(6, 16, 16)
+    # Not a power of two: the vectors are enumerated.
+    enumerated = counter_inputs(6, 16, 15) + [0]
+    assert [word & 0x7FFF for word in aligned] == enumerated[:6]
+    assert aligned[0] == 0b1010101010101010
+    assert aligned[3] == 0b1111111100000000
+    assert aligned[4] == 0b1111111111111111
+    assert aligned[5] == 0
+
+
+@pytest.mark.parametrize("workers", [1, 2])
+@pytest.mark.parametrize(
+    "level",
+    [
+        OptimizationLevel.BIT_PARALLEL,
+        pytest.param(
+            OptimizationLevel.GPU,
+            marks=pytest.mark.skipif(not is_gpu_available(), reason="no CuPy GPU"),
+        ),
+        None,
+    ],
+    ids=["bit_parallel", "gpu", "default"],
+)
+def test_4bits_adder_truth_table(workers, level, library):
+    circuit = library.get_circuit("4-Bits Adder")
+
+    # Inputs : a0, b0, c0, a1, b1, a2, b2, a3, b3
+    a_indices = [0, 3, 5, 7]
+    b_indices = [1, 4, 6, 8]
+    expected_start = 0
+    for chunk in exhaustive_truth_table(
+        circuit, workers=workers, chunk_lanes=64, level=level
+    ):
+        assert chunk.start == expected_start
+        assert chunk.lanes == 64
+        expected_start += chunk.lanes
+
+        for vector, outputs in chunk.rows():
+            inputs = int_to_bools(9)(vector)
+            a = bools_to_int([inputs[i] for i in a_indices])
+            b = bools_to_int([inputs[i] for i in b_indices])
+            assert outputs == int_to_bools(5)(a + b + inputs[2])
+
+    assert expected_start == 2**9
+
+
+def test_truth_table_rejects_single_vector_level(library):
+    circuit = library.get_circuit("Half-Adder")
+    with pytest.raises(ValueError):
+        next(exhaustive_truth_table(circuit, level=OptimizationLevel.FAST))
+
+
+def test_truth_table_keeps_circuit(library):
+    """The circuit isn't optimized in place, even without workers."""
+    circuit = library.get_circuit("Full-Adder")
+    circuit.components = dict(reversed(circuit.components.items()))
+    order = list(circuit.components)
+    chunks = list(exhaustive_truth_table(circuit, level=OptimizationLevel.BIT_PARALLEL))
+    assert sum(chunk.lanes for chunk in chunks) == 8
+    assert list(circuit.components) == order
+
+
+def test_truth_tables_interleaved(library):
+    """Two truth tables consumed at once each simulate their own circuit."""
+    and_table = exhaustive_truth_table(library.get_circuit("AND"), chunk_lanes=1)
+    or_table = exhaustive_truth_table(library.get_circuit("OR"), chunk_lanes=1)
+    for and_chunk, or_chunk in zip(and_table, or_table):
+        [(vector, and_outputs)] = and_chunk.rows()
+        [(_, or_outputs)] = or_chunk.rows()
+        a, b = vector & 1, vector >> 1
+        assert and_outputs == [bool(a and b)]
+        assert or_outputs == [bool(a or b)]